@@ -0,0 +1,291 @@
+/*
+ * @f ccn-lite-csbench.c
+ * @b replays a name trace against the content store replacement policies
+ *
+ * Copyright (C) 2026, the CCN-lite contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ * File history:
+ * 2026-10-17 created
+ */
+
+// Each name of the trace is looked up in the content store of an
+// otherwise idle relay. On a miss, a content object of the given size
+// is added to the cache (as if it had been fetched from upstream).
+// Without a trace file, a Zipf distributed trace is generated.
+
+#define CCNL_UNIX
+
+#define USE_DEBUG
+#define USE_MEMPOOL
+#define USE_SUITE_NDNTLV
+
+// only the cache is measured, whatever else the Makefile turns on
+#undef USE_NFN
+#undef USE_NFN_MONITOR
+#undef USE_NACK
+
+#include "ccnl-os-includes.h"
+
+#include "ccnl-defs.h"
+#include "ccnl-core.h"
+#include "ccnl-ext.h"
+
+void ccnl_core_addToCleanup(struct ccnl_buf_s *buf);
+
+#include "ccnl-ext-mempool.c"
+#include "ccnl-ext-debug.c"
+#include "ccnl-os-time.c"
+#include "ccnl-ext-logging.c"
+
+int ccnl_app_RX(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c);
+
+#include "ccnl-core.c"
+
+#include <math.h>
+
+// ----------------------------------------------------------------------
+// the relay never sends or delivers anything
+
+int
+ccnl_app_RX(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c)
+{
+    return 0;
+}
+
+void
+ccnl_ll_TX(struct ccnl_relay_s *relay, struct ccnl_if_s *ifc,
+           sockunion *dst, struct ccnl_buf_s *buf)
+{
+}
+
+void
+ccnl_close_socket(int s)
+{
+}
+
+// ----------------------------------------------------------------------
+
+struct ccnl_prefix_s **trace;
+int tracelen;
+
+int
+csbench_addname(char *uri)
+{
+    static int tracemax;
+
+    if (tracelen >= tracemax) {
+        tracemax = tracemax ? 2 * tracemax : 1024;
+        trace = ccnl_realloc(trace, tracemax * sizeof(*trace));
+        if (!trace)
+            return -1;
+    }
+    trace[tracelen] = ccnl_URItoPrefix(uri, CCNL_SUITE_NDNTLV, NULL, NULL);
+    if (!trace[tracelen])
+        return -1;
+    tracelen++;
+    return 0;
+}
+
+int
+csbench_readtrace(char *fname)
+{
+    FILE *f = strcmp(fname, "-") ? fopen(fname, "r") : stdin;
+    char line[4096], *cp;
+
+    if (!f) {
+        perror(fname);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), f)) {
+        cp = line + strcspn(line, "\r\n");
+        *cp = '\0';
+        if (line[0] != '/')
+            continue;
+        if (csbench_addname(line))
+            return -1;
+    }
+    if (f != stdin)
+        fclose(f);
+    return 0;
+}
+
+// n requests over 'objects' names, the k-th name with probability ~ 1/k^alpha
+int
+csbench_zipftrace(int n, int objects, double alpha)
+{
+    double *cdf = ccnl_malloc(objects * sizeof(double)), sum = 0, u;
+    char uri[64];
+    int i, lo, hi;
+
+    if (!cdf)
+        return -1;
+    for (i = 0; i < objects; i++)
+        cdf[i] = (sum += 1 / pow(i + 1, alpha));
+    srandom(1);
+    while (n-- > 0) {
+        u = sum * (random() / (RAND_MAX + 1.0));
+        for (lo = 0, hi = objects - 1; lo < hi; ) {
+            i = (lo + hi) / 2;
+            if (cdf[i] < u)
+                lo = i + 1;
+            else
+                hi = i;
+        }
+        sprintf(uri, "/ccnl/csbench/obj%d", lo);
+        if (csbench_addname(uri)) {
+            ccnl_free(cdf);
+            return -1;
+        }
+    }
+    ccnl_free(cdf);
+    return 0;
+}
+
+void
+csbench_run(char *policy, int max_cache_entries, long max_cache_bytes,
+            int size)
+{
+    struct ccnl_relay_s relay;
+    struct ccnl_content_s *c;
+    struct ccnl_prefix_s *p;
+    struct ccnl_buf_s *pkt;
+    struct timeval t0, t1;
+    int i, hits = 0;
+    double usec;
+
+    memset(&relay, 0, sizeof(relay));
+    relay.max_cache_entries = max_cache_entries;
+    relay.max_cache_bytes = max_cache_bytes;
+    if (ccnl_cache_setpolicy(&relay, policy))
+        return;
+
+    gettimeofday(&t0, NULL);
+    for (i = 0; i < tracelen; i++) {
+        c = ccnl_cs_find(&relay, NULL, CCNL_SUITE_NDNTLV, trace[i]);
+        if (c) {
+            ccnl_content_used(&relay, c);
+            hits++;
+            continue;
+        }
+        p = ccnl_prefix_dup(trace[i]);
+        pkt = ccnl_buf_new(NULL, size);
+        c = ccnl_content_new(&relay, CCNL_SUITE_NDNTLV, &pkt, &p,
+                             NULL, NULL, 0);
+        if (c && !ccnl_content_add2cache(&relay, c))
+            free_content(c);
+        free_prefix(p);
+        ccnl_free(pkt);
+    }
+    gettimeofday(&t1, NULL);
+    usec = (t1.tv_sec - t0.tv_sec) * 1e6 + (t1.tv_usec - t0.tv_usec);
+
+    printf("%-10s %9d %9d %7.2f%% %9.3f\n", policy, tracelen, hits,
+           tracelen ? 100.0 * hits / tracelen : 0.0,
+           tracelen ? usec / tracelen : 0.0);
+    ccnl_core_cleanup(&relay);
+}
+
+// ----------------------------------------------------------------------
+
+int
+main(int argc, char **argv)
+{
+    char *policies[] = {"lru", "lfu", "arc", "wtinylfu", NULL}, *policy = NULL;
+    int opt, i, max_cache_entries = 1000, objects = 100000, n = 1000000;
+    int size = 1024;
+    long max_cache_bytes = 0;
+    double alpha = 0.8;
+
+    while ((opt = getopt(argc, argv, "a:b:c:hl:n:r:s:v:")) != -1) {
+        switch (opt) {
+        case 'a':
+            alpha = atof(optarg);
+            break;
+        case 'b':
+            max_cache_bytes = atol(optarg);
+            break;
+        case 'c':
+            max_cache_entries = atoi(optarg);
+            break;
+        case 'l':
+            n = atoi(optarg);
+            break;
+        case 'n':
+            objects = atoi(optarg);
+            break;
+        case 'r':
+            policy = optarg;
+            break;
+        case 's':
+            size = atoi(optarg);
+            break;
+        case 'v':
+            if (isdigit(optarg[0]))
+                debug_level = atoi(optarg);
+            else
+                debug_level = ccnl_debug_str2level(optarg);
+            break;
+        case 'h':
+        default:
+usage:
+            fprintf(stderr, "usage: %s [options] [TRACEFILE]\n"
+                    "  -a ZIPF_ALPHA (default: 0.8)\n"
+                    "  -b MAX_CONTENT_BYTES\n"
+                    "  -c MAX_CONTENT_ENTRIES (default: 1000)\n"
+                    "  -h\n"
+                    "  -l TRACE_LENGTH (default: 1000000)\n"
+                    "  -n NUMBER_OF_OBJECTS (default: 100000)\n"
+                    "  -r CACHE_POLICY (lru, lfu, arc, wtinylfu; default: all)\n"
+                    "  -s CONTENT_SIZE (default: 1024)\n"
+                    "  -v DEBUG_LEVEL (fatal, error, warning, info, debug, trace, verbose)\n"
+                    "TRACEFILE has one name (URI) per line, - for stdin;\n"
+                    "without it, a Zipf distributed trace is generated\n",
+                    argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (optind < argc - 1 || n <= 0 || objects <= 0 || size < 0)
+        goto usage;
+
+    ccnl_core_init();
+
+    if (optind < argc ? csbench_readtrace(argv[optind]) :
+                        csbench_zipftrace(n, objects, alpha)) {
+        fprintf(stderr, "could not load the trace\n");
+        return -1;
+    }
+
+    printf("%-10s %9s %9s %8s %9s\n",
+           "policy", "requests", "hits", "ratio", "usec/req");
+    if (policy)
+        csbench_run(policy, max_cache_entries, max_cache_bytes, size);
+    else
+        for (i = 0; policies[i]; i++)
+            csbench_run(policies[i], max_cache_entries, max_cache_bytes, size);
+
+    for (i = 0; i < tracelen; i++)
+        free_prefix(trace[i]);
+    ccnl_free(trace);
+    ccnl_timer_cleanup();
+#ifdef USE_MEMPOOL
+    if (debug_level >= DEBUG)
+        ccnl_mempool_dump(0);
+    ccnl_mempool_cleanup();
+#endif
+
+    return 0;
+}
+
+// eof
@@ -375,17 +375,6 @@ Bail:
 
 // ----------------------------------------------------------------------
 
-static void
-ccnl_ageing(void *ptr, void *dummy)
-{
-    struct ccnl_relay_s *relay = (struct ccnl_relay_s*) ptr;
-
-    ccnl_do_ageing(relay, dummy);
-    ccnl_set_timer(1000000, ccnl_ageing, relay, dummy);
-}
-
-// ----------------------------------------------------------------------
-
 struct net_device*
 ccnl_open_ethdev(char *devname, struct sockaddr_ll *sll, int ethtype)
 {
@@ -482,7 +471,6 @@ static int v = 0;
 static char *p = NULL;
 static char *k = NULL;
 static char *s = NULL;
-static void *ageing_handler = NULL;
 
 
 module_param(e, charp, 0);
@@ -552,8 +540,6 @@ ccnl_init(void)
     theRelay.defaultFaceScheduler = ccnl_lnx_defaultFaceScheduler;
 #endif
 
-    ageing_handler = ccnl_set_timer(1000000, ccnl_ageing, &theRelay, 0);
-
 #ifdef USE_UNIXSOCKET
     if (x) {
         i = &theRelay.ifs[theRelay.ifcount];
@@ -661,11 +647,6 @@ ccnl_lnxkernel_cleanup(void)
 
     printk("%s: ccnl_lnxkernel_cleanup\n", THIS_MODULE->name);
 
-    if (ageing_handler) {
-        ccnl_rem_timer(ageing_handler);
-        ageing_handler = 0;
-    }
-
     ccnl_core_cleanup(&theRelay);
 
     for (j = 0; j < theRelay.ifcount; j++) {
@@ -737,9 +718,6 @@ ccnl_exit( void )
 {
     DEBUGMSG(INFO, "%s: exit\n", THIS_MODULE->name);
 
-    if (ageing_handler)
-        ccnl_rem_timer(ageing_handler);
-
     flush_scheduled_work();
     ccnl_lnxkernel_cleanup();
 
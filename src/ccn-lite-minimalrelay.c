@@ -71,6 +71,7 @@ int inet_aton(const char *cp, struct in_addr *inp);
 
 #define ccnl_malloc(s)                  malloc(s)
 #define ccnl_calloc(n,s)                calloc(n,s)
+#define ccnl_calloc_type(k,s)           calloc(1,s)
 #define ccnl_realloc(p,s)               realloc(p,s)
 #define ccnl_free(p)                    free(p)
 
@@ -78,16 +79,26 @@ int inet_aton(const char *cp, struct in_addr *inp);
 #define free_3ptr_list(a,b,c)   ccnl_free(a), ccnl_free(b), ccnl_free(c)
 #define free_4ptr_list(a,b,c,d) ccnl_free(a), ccnl_free(b), ccnl_free(c), ccnl_free(d);
 
-#define free_prefix(p)  do{ if(p) \
-                free_4ptr_list(p->bytes,p->comp,p->complen,p); } while(0)
+// a compact prefix is one allocation, see ccnl_prefix_alloc()
+#define free_prefix(p)  do{ if(p) { \
+                if (!(p)->compact) \
+                    free_3ptr_list(p->bytes,p->comp,p->complen); \
+                free_2ptr_list(p->chunknum,p); } } while(0)
 #define free_content(c) do{ free_prefix(c->name); \
-                        free_2ptr_list(c->pkt, c); } while(0)
+                        ccnl_buf_release(c->pkt); ccnl_free(c); } while(0)
 
 #define ccnl_frag_new(a,b)                      NULL
 #define ccnl_frag_destroy(e)                    do {} while(0)
 
 #define ccnl_sched_destroy(s)           do {} while(0)
 
+// one relay, one event queue (see below)
+#define ccnl_timerq_select(q)           ((void)(q), (struct ccnl_timerq_s*) NULL)
+#define ccnl_timerq_free(q)             do {} while(0)
+#define CCNL_THREADLOCAL
+
+#define ccnl_worker_steer(r,f,s,p,b)    0
+
 #define ccnl_mgmt(r,b,p,f)              -1
 
 #define ccnl_nfn_monitor(a,b,c,d,e)     do{}while(0)
@@ -126,11 +137,28 @@ ccnl_buf_new(void *data, int len)
         return NULL;
     b->next = NULL;
     b->datalen = len;
+    b->refcnt = 1;
+    b->fp = 0;
     if (data)
         memcpy(b->data, data, len);
     return b;
 }
 
+struct ccnl_buf_s*
+ccnl_buf_ref(struct ccnl_buf_s *buf)
+{
+    if (buf)
+        buf->refcnt++;
+    return buf;
+}
+
+void
+ccnl_buf_release(struct ccnl_buf_s *buf)
+{
+    if (buf && --buf->refcnt <= 0)
+        ccnl_free(buf);
+}
+
 // ----------------------------------------------------------------------
 // timer support and event server
 
@@ -279,12 +307,6 @@ ccnl_open_udpdev(int port)
     return s;
 }
 
-void ccnl_minimalrelay_ageing(void *relay, void *aux)
-{
-    ccnl_do_ageing(relay, aux);
-    ccnl_set_timer(1000000, ccnl_minimalrelay_ageing, relay, 0);
-}
-
 void
 ccnl_io_loop(struct ccnl_relay_s *ccnl)
 {
@@ -406,9 +428,8 @@ usage:
     fwd->suite = suite;
     fwd->face = ccnl_get_face_or_create(&theRelay, 0, &sun.sa, sizeof(sun.ip4));
     fwd->face->flags |= CCNL_FACE_FLAGS_STATIC;
-    theRelay.fib = fwd;
+    ccnl_fib_add(&theRelay, fwd);
 
-    ccnl_set_timer(1000000, ccnl_minimalrelay_ageing, &theRelay, 0);
     ccnl_io_loop(&theRelay);
 
     return 0;
@@ -20,6 +20,8 @@
  * 2011-11-22 created
  */
 
+#define _GNU_SOURCE // recvmmsg(), sendmmsg()
+
 #include <dirent.h>
 #include <fnmatch.h>
 #include <regex.h>
@@ -31,9 +33,12 @@
 #define USE_CCNxDIGEST
 #define USE_DEBUG                      // must select this for USE_MGMT
 #define USE_DEBUG_MALLOC
+#define USE_EPOLL                      // else select(), Linux only
 // #define USE_FRAG
 #define USE_ETHERNET
 #define USE_HTTP_STATUS
+#define USE_IOBATCH                    // recvmmsg()/sendmmsg(), Linux only
+#define USE_MEMPOOL
 #define USE_MGMT
 // #define USE_NACK
 // #define USE_NFN
@@ -47,6 +52,7 @@
 #define USE_SUITE_LOCALRPC
 #define USE_UNIXSOCKET
 // #define USE_SIGNATURES
+#define USE_WORKERS                    // -w: one process per core, Linux only
 
 #include "ccnl-os-includes.h"
 
@@ -54,6 +60,7 @@
 #include "ccnl-core.h"
 
 #include "ccnl-ext.h"
+#include "ccnl-ext-mempool.c"
 #include "ccnl-ext-debug.c"
 #include "ccnl-os-time.c"
 #include "ccnl-ext-logging.c"
@@ -71,34 +78,29 @@
 #include "ccnl-ext-sched.c"
 #include "ccnl-ext-frag.c"
 #include "ccnl-ext-crypto.c"
+#include "ccnl-ext-workers.c"
 
 // ----------------------------------------------------------------------
 
-struct ccnl_relay_s theRelay;
 char suite = CCNL_SUITE_DEFAULT; 
 
 struct timeval*
 ccnl_run_events()
 {
     static struct timeval now;
+    struct ccnl_timer_s *t;
     long usec;
 
+    ccnl_clock_tick();
     gettimeofday(&now, 0);
-    while (eventqueue) {
-        struct ccnl_timer_s *t = eventqueue;
-
+    while ((t = ccnl_timer_first())) {
         usec = timevaldelta(&(t->timeout), &now);
         if (usec >= 0) {
             now.tv_sec = usec / 1000000;
             now.tv_usec = usec % 1000000;
             return &now;
         }
-        if (t->fct)
-            (t->fct)(t->node, t->intarg);
-        else if (t->fct2)
-            (t->fct2)(t->aux1, t->aux2);
-        eventqueue = t->next;
-        ccnl_free(t);
+        ccnl_timer_fire(t);
     }
 
     return NULL;
@@ -192,6 +194,12 @@ ccnl_open_udpdev(int port, struct sockaddr_in *si)
     si->sin_addr.s_addr = INADDR_ANY;
     si->sin_port = htons(port);
     si->sin_family = PF_INET;
+#ifdef USE_WORKERS
+    if (ccnl_worker.cnt > 1) { // all workers share the port
+        int on = 1;
+        setsockopt(s, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+    }
+#endif
     if(bind(s, (struct sockaddr *)si, sizeof(*si)) < 0) {
         perror("udp sock bind");
         return -1;
@@ -227,12 +235,223 @@ ccnl_eth_sendto(int sock, unsigned char *dst, unsigned char *src,
 }
 #endif // USE_ETHERNET
 
+#ifdef USE_IOBATCH
+
+// With USE_IOBATCH, UDP and UNIX datagrams are not sent right away but
+// collected per interface, holding a reference to the buf, and the IO
+// loop sends each interface's batch with one sendmmsg() per round.
+struct ccnl_txbatch_s {
+    int cnt;
+    struct mmsghdr msg[CCNL_IO_BATCH];
+    struct iovec iov[CCNL_IO_BATCH];
+    sockunion dst[CCNL_IO_BATCH];
+    struct ccnl_buf_s *buf[CCNL_IO_BATCH];
+};
+
+// same for receiving, one ring shared by all interfaces as the core
+// copies what it keeps
+struct ccnl_rxbatch_s {
+    struct mmsghdr msg[CCNL_IO_BATCH];
+    struct iovec iov[CCNL_IO_BATCH];
+    sockunion src[CCNL_IO_BATCH];
+    unsigned char buf[CCNL_IO_BATCH][CCNL_MAX_PACKET_SIZE];
+};
+
+struct ccnl_iobatch_s {
+    struct ccnl_txbatch_s tx[CCNL_MAX_INTERFACES];
+    struct ccnl_rxbatch_s rx;
+};
+
+// the batches belong to the relay, so that relays running in different
+// threads do not share them; allocated on first use, NULL if that failed
+static struct ccnl_iobatch_s*
+ccnl_io_batches(struct ccnl_relay_s *ccnl)
+{
+    if (!ccnl->iobatch)
+        ccnl->iobatch = (struct ccnl_iobatch_s*)
+                                ccnl_calloc(1, sizeof(struct ccnl_iobatch_s));
+    return ccnl->iobatch;
+}
+
+static void
+ccnl_io_counthist(unsigned long *hist, int n)
+{
+    int b;
+
+    for (b = 0; n > 1 && b < CCNL_IO_HISTLEN - 1; b++)
+        n >>= 1;
+    hist[b]++;
+}
+
+// sends an interface's batch; what the socket does not take now
+// (EAGAIN) stays in the batch, at its front, for the next flush
+void
+ccnl_io_flush(struct ccnl_relay_s *ccnl, int ifndx)
+{
+    struct ccnl_txbatch_s *tb;
+    int i, j, rc;
+
+    if (!ccnl->iobatch)
+        return;
+    tb = ccnl->iobatch->tx + ifndx;
+    if (tb->cnt <= 0)
+        return;
+    ccnl_io_counthist(ccnl->ifs[ifndx].txbatch, tb->cnt);
+    for (i = 0; i < tb->cnt;) {
+        rc = sendmmsg(ccnl->ifs[ifndx].sock, tb->msg + i, tb->cnt - i, 0);
+        DEBUGMSG(DEBUG, "sendmmsg (%d datagrams) returned %d\n",
+                 tb->cnt - i, rc);
+        if (rc > 0)
+            i += rc;
+        else if (rc < 0 && errno == EINTR)
+            continue;
+        else if (rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        else // a datagram which cannot be sent is dropped, as with sendto()
+            i++;
+    }
+    for (j = 0; j < i; j++)
+        ccnl_buf_release(tb->buf[j]);
+    for (j = 0; i < tb->cnt; i++, j++) {
+        tb->dst[j] = tb->dst[i];
+        tb->iov[j] = tb->iov[i];
+        tb->buf[j] = tb->buf[i];
+        tb->msg[j] = tb->msg[i];
+        tb->msg[j].msg_hdr.msg_name = tb->dst + j;
+        tb->msg[j].msg_hdr.msg_iov = tb->iov + j;
+    }
+    tb->cnt = j;
+    // a full batch holds back the interface's ring, see ccnl_io_drain()
+    ccnl->ifs[ifndx].txbusy = tb->cnt >= CCNL_IO_BATCH;
+}
+
+// datagrams still waiting in an interface's batch
+int
+ccnl_io_txpending(struct ccnl_relay_s *ccnl, int ifndx)
+{
+    return ccnl->iobatch ? ccnl->iobatch->tx[ifndx].cnt : 0;
+}
+
+void
+ccnl_io_batchstats(struct ccnl_relay_s *ccnl)
+{
+    int i;
+
+    for (i = 0; i < ccnl->ifcount; i++) {
+        DEBUGMSG(INFO, "i%d rx batches: %s\n",
+                 i, ccnl_iohist2ascii(ccnl->ifs[i].rxbatch));
+        DEBUGMSG(INFO, "i%d tx batches: %s\n",
+                 i, ccnl_iohist2ascii(ccnl->ifs[i].txbatch));
+        DEBUGMSG(INFO, "i%d tx queue: sent=%lu dropped=%lu peak=%d "
+                 "sojourn max=%.3fms\n", i, ccnl->ifs[i].txcnt,
+                 ccnl->ifs[i].drops, ccnl->ifs[i].qpeak,
+                 1000 * ccnl->ifs[i].sojournmax);
+    }
+}
+
+// returns 0 if the datagram was queued, -1 if it must be sent directly
+static int
+ccnl_io_batchTX(struct ccnl_relay_s *ccnl, struct ccnl_if_s *ifc,
+                sockunion *dest, struct ccnl_buf_s *buf, int addrlen)
+{
+    int ifndx = ifc - ccnl->ifs;
+    struct ccnl_txbatch_s *tb;
+    struct mmsghdr *m;
+
+    if (!ccnl_io_batches(ccnl))
+        return -1;
+    tb = ccnl->iobatch->tx + ifndx;
+    if (tb->cnt >= CCNL_IO_BATCH)
+        ccnl_io_flush(ccnl, ifndx);
+    if (tb->cnt >= CCNL_IO_BATCH) { // only if CTS ignores txbusy (scheduler)
+        DEBUGMSG(WARNING, "  DROPPING buf=%p\n", (void*)buf);
+        ifc->drops++;
+        return 0;
+    }
+    m = tb->msg + tb->cnt;
+    memcpy(tb->dst + tb->cnt, dest, addrlen);
+    tb->iov[tb->cnt].iov_base = buf->data;
+    tb->iov[tb->cnt].iov_len = buf->datalen;
+    memset(m, 0, sizeof(*m));
+    m->msg_hdr.msg_name = tb->dst + tb->cnt;
+    m->msg_hdr.msg_namelen = addrlen;
+    m->msg_hdr.msg_iov = tb->iov + tb->cnt;
+    m->msg_hdr.msg_iovlen = 1;
+    tb->buf[tb->cnt++] = ccnl_buf_ref(buf);
+    if (tb->cnt >= CCNL_IO_BATCH)
+        ccnl_io_flush(ccnl, ifndx);
+    return 0;
+}
+
+void
+ccnl_io_batchcleanup(struct ccnl_relay_s *ccnl)
+{
+    int i;
+
+    if (!ccnl->iobatch)
+        return;
+    for (i = 0; i < ccnl->ifcount; i++) {
+        struct ccnl_txbatch_s *tb = ccnl->iobatch->tx + i;
+
+        ccnl_io_flush(ccnl, i);
+        while (tb->cnt > 0)
+            ccnl_buf_release(tb->buf[--tb->cnt]);
+    }
+    ccnl_free(ccnl->iobatch);
+    ccnl->iobatch = NULL;
+}
+
+#endif // USE_IOBATCH
+
+// sends what waits in an interface's ring, as long as the socket takes
+// it (at most CCNL_IO_BATCH packets per call), returns 1 if more is left
+// which could be sent now
+static int
+ccnl_io_drain(struct ccnl_relay_s *ccnl, int i)
+{
+#ifndef USE_SCHEDULER // else the scheduler paces the ring itself
+    struct ccnl_if_s *ifc = ccnl->ifs + i;
+    int k;
+#endif
+
+#ifdef USE_IOBATCH
+    ccnl_io_flush(ccnl, i);
+#endif
+#ifndef USE_SCHEDULER
+    for (k = 0; k < CCNL_IO_BATCH && ifc->qlen > 0 && !ifc->txbusy; k++)
+        ccnl_interface_CTS(ccnl, ifc);
+#ifdef USE_IOBATCH
+    ccnl_io_flush(ccnl, i);
+#endif
+    return ifc->qlen > 0 && !ifc->txbusy;
+#else
+    return 0;
+#endif
+}
+
 void
 ccnl_ll_TX(struct ccnl_relay_s *ccnl, struct ccnl_if_s *ifc,
            sockunion *dest, struct ccnl_buf_s *buf)
 {
     int rc;
 
+#ifdef USE_IOBATCH
+    switch(dest->sa.sa_family) {
+    case AF_INET:
+        if (!ccnl_io_batchTX(ccnl, ifc, dest, buf, sizeof(struct sockaddr_in)))
+            return;
+        break;
+#ifdef USE_UNIXSOCKET
+    case AF_UNIX:
+        if (!ccnl_io_batchTX(ccnl, ifc, dest, buf, sizeof(struct sockaddr_un)))
+            return;
+        break;
+#endif
+    default: // Ethernet frames are built and sent one by one
+        break;
+    }
+#endif
+
     switch(dest->sa.sa_family) {
     case AF_INET:
         rc = sendto(ifc->sock,
@@ -307,24 +526,19 @@ ccnl_relay_defaultInterfaceScheduler(struct ccnl_relay_s *ccnl,
 #endif // USE_SCHEDULER
 
 
-void ccnl_ageing(void *relay, void *aux)
-{
-    ccnl_do_ageing(relay, aux);
-    ccnl_set_timer(1000000, ccnl_ageing, relay, 0);
-}
-
 // ----------------------------------------------------------------------
 
 void
 ccnl_relay_config(struct ccnl_relay_s *relay, char *ethdev, int udpport,
                   int httpport, char *uxpath, int suite, int max_cache_entries,
-                  char *crypto_face_path)
+                  long max_cache_bytes, char *crypto_face_path)
 {
     struct ccnl_if_s *i;
 
     DEBUGMSG(INFO, "configuring relay\n");
 
     relay->max_cache_entries = max_cache_entries;       
+    relay->max_cache_bytes = max_cache_bytes;
 #ifdef USE_SCHEDULER
     relay->defaultFaceScheduler = ccnl_relay_defaultFaceScheduler;
     relay->defaultInterfaceScheduler = ccnl_relay_defaultInterfaceScheduler;
@@ -440,23 +654,239 @@ ccnl_relay_config(struct ccnl_relay_s *relay, char *ethdev, int udpport,
     }
 #endif //USE_SIGNATURES
 #endif // USE_UNIXSOCKET
-
-    ccnl_set_timer(1000000, ccnl_ageing, relay, 0);
 }
 
 // ----------------------------------------------------------------------
 
+// hands a received datagram to the core
+static void
+ccnl_io_deliver(struct ccnl_relay_s *ccnl, int i, unsigned char *buf, int len,
+                sockunion *src_addr)
+{
+    if (len <= 0)
+        return;
+    if (src_addr->sa.sa_family == AF_INET) {
+        ccnl_core_RX(ccnl, i, buf, len,
+                     &src_addr->sa, sizeof(src_addr->ip4));
+    }
+#ifdef USE_ETHERNET
+    else if (src_addr->sa.sa_family == AF_PACKET) {
+        if (len > 14)
+            ccnl_core_RX(ccnl, i, buf+14, len-14,
+                         &src_addr->sa, sizeof(src_addr->eth));
+    }
+#endif
+#ifdef USE_UNIXSOCKET
+    else if (src_addr->sa.sa_family == AF_UNIX) {
+        ccnl_core_RX(ccnl, i, buf, len,
+                     &src_addr->sa, sizeof(src_addr->ux));
+    }
+#endif
+}
+
+// reads up to max datagrams from interface i without blocking, returns
+// how many were read (less than max: the socket is empty), or -1 if the
+// read was interrupted and should be tried again
+static int
+ccnl_io_recv(struct ccnl_relay_s *ccnl, int i, int max)
+{
+    unsigned char buf[CCNL_MAX_PACKET_SIZE];
+    sockunion src_addr;
+    socklen_t addrlen;
+    int len, n;
+#ifdef USE_IOBATCH
+    struct ccnl_rxbatch_s *rb;
+    int k;
+
+    if (ccnl_io_batches(ccnl)) {
+        rb = &ccnl->iobatch->rx;
+        if (max > CCNL_IO_BATCH)
+            max = CCNL_IO_BATCH;
+        for (k = 0; k < max; k++) {
+            rb->iov[k].iov_base = rb->buf[k];
+            rb->iov[k].iov_len = sizeof(rb->buf[k]);
+            memset(&rb->msg[k], 0, sizeof(rb->msg[k]));
+            rb->msg[k].msg_hdr.msg_name = rb->src + k;
+            rb->msg[k].msg_hdr.msg_namelen = sizeof(sockunion);
+            rb->msg[k].msg_hdr.msg_iov = rb->iov + k;
+            rb->msg[k].msg_hdr.msg_iovlen = 1;
+        }
+        n = recvmmsg(ccnl->ifs[i].sock, rb->msg, max, MSG_DONTWAIT, NULL);
+        if (n < 0)
+            return (errno == EINTR || errno == ECONNREFUSED) ? -1 : 0;
+        if (n > 0)
+            ccnl_io_counthist(ccnl->ifs[i].rxbatch, n);
+        for (k = 0; k < n; k++)
+            ccnl_io_deliver(ccnl, i, rb->buf[k], rb->msg[k].msg_len,
+                            rb->src + k);
+        return n;
+    }
+    // no memory for the batch: one datagram at a time
+#endif
+
+    for (n = 0; n < max; n++) {
+        addrlen = sizeof(sockunion);
+        len = recvfrom(ccnl->ifs[i].sock, buf, sizeof(buf), MSG_DONTWAIT,
+                       (struct sockaddr*) &src_addr, &addrlen);
+        if (len < 0)
+            return (!n && (errno == EINTR || errno == ECONNREFUSED)) ? -1 : n;
+        ccnl_io_deliver(ccnl, i, buf, len, &src_addr);
+    }
+    return n;
+}
+
+#ifdef USE_EPOLL
+
+#define CCNL_EPOLL_MAXEVENTS    (CCNL_MAX_INTERFACES + 1)
+
+// The interfaces are registered edge-triggered: a wakeup marks an
+// interface as ready, and it is read until it would block, at most
+// CCNL_IO_BATCH datagrams per round so that a busy interface cannot
+// starve the others. Write readiness is asked for only while an
+// interface has packets queued, in its ring or its send batch. The HTTP
+// status sockets are in the same set, with ev.data.ptr pointing to the
+// http struct instead of an ifs[].
+int
+ccnl_io_epoll_loop(struct ccnl_relay_s *ccnl, int epfd)
+{
+    struct epoll_event ev, events[CCNL_EPOLL_MAXEVENTS];
+    char rxready[CCNL_MAX_INTERFACES], txready[CCNL_MAX_INTERFACES];
+    char txwanted[CCNL_MAX_INTERFACES];
+    struct timeval *tv;
+    int i, k, n, timeout, pending, want;
+
+    memset(&ev, 0, sizeof(ev));
+    memset(txready, 0, sizeof(txready));
+    memset(txwanted, 0, sizeof(txwanted));
+    for (i = 0; i < ccnl->ifcount; i++) {
+        ev.events = EPOLLIN | EPOLLET;
+        ev.data.ptr = ccnl->ifs + i;
+        if (epoll_ctl(epfd, EPOLL_CTL_ADD, ccnl->ifs[i].sock, &ev) < 0) {
+            perror("epoll_ctl(): ");
+            exit(EXIT_FAILURE);
+        }
+        rxready[i] = 1; // there might be data from before
+    }
+#ifdef USE_WORKERS
+    if (ccnl_worker_wakefd() >= 0) {
+        ev.events = EPOLLIN;
+        ev.data.ptr = &ccnl_worker;
+        epoll_ctl(epfd, EPOLL_CTL_ADD, ccnl_worker_wakefd(), &ev);
+    }
+#endif
+
+    while (!ccnl->halt_flag) {
+        tv = ccnl_run_events();
+        for (i = 0; i < ccnl->ifcount; i++)
+            ccnl_io_drain(ccnl, i);
+#ifdef USE_WORKERS
+        ccnl_worker_poll(ccnl);
+#endif
+
+        pending = 0;
+        for (i = 0; i < ccnl->ifcount; i++) {
+            if (rxready[i] || txready[i])
+                pending = 1;
+            want = ccnl->ifs[i].qlen > 0;
+#ifdef USE_IOBATCH
+            want = want || ccnl_io_txpending(ccnl, i) > 0;
+#endif
+            if (want != txwanted[i]) {
+                txwanted[i] = !txwanted[i];
+                ev.events = EPOLLIN | EPOLLET | (txwanted[i] ? EPOLLOUT : 0);
+                ev.data.ptr = ccnl->ifs + i;
+                epoll_ctl(epfd, EPOLL_CTL_MOD, ccnl->ifs[i].sock, &ev);
+            }
+        }
+#ifdef USE_HTTP_STATUS
+        ccnl_http_epollctl(ccnl->http, epfd);
+#endif
+        if (pending)
+            timeout = 0;
+        else if (tv)
+            timeout = tv->tv_sec * 1000 + (tv->tv_usec + 999) / 1000;
+        else
+            timeout = -1;
+
+        n = epoll_wait(epfd, events, CCNL_EPOLL_MAXEVENTS, timeout);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("epoll_wait(): ");
+            exit(EXIT_FAILURE);
+        }
+        ccnl_clock_tick();
+
+        for (k = 0; k < n; k++) {
+#ifdef USE_HTTP_STATUS
+            if (ccnl->http && events[k].data.ptr == ccnl->http) {
+                ccnl_http_epollevent(ccnl, ccnl->http, events[k].events);
+                continue;
+            }
+#endif
+#ifdef USE_WORKERS
+            if (events[k].data.ptr == &ccnl_worker) {
+                ccnl_worker_RX(ccnl);
+                continue;
+            }
+#endif
+            i = (struct ccnl_if_s*) events[k].data.ptr - ccnl->ifs;
+            if (events[k].events & (EPOLLIN | EPOLLERR | EPOLLHUP))
+                rxready[i] = 1;
+            if (events[k].events & EPOLLOUT)
+                txready[i] = 1;
+        }
+
+        for (i = 0; i < ccnl->ifcount; i++) {
+            for (k = 0; rxready[i] && k < CCNL_IO_BATCH; k += n > 0 ? n : 1) {
+                n = ccnl_io_recv(ccnl, i, CCNL_IO_BATCH - k);
+                if (n >= 0 && n < CCNL_IO_BATCH - k)
+                    rxready[i] = 0;
+            }
+            if (txready[i]) {
+                // if busy, the socket said EAGAIN: wait for the next EPOLLOUT
+                if (!ccnl_io_drain(ccnl, i))
+                    txready[i] = 0;
+            }
+        }
+    }
+#ifdef USE_IOBATCH
+    for (i = 0; i < ccnl->ifcount; i++)
+        ccnl_io_flush(ccnl, i);
+#endif
+
+    return 0;
+}
+
+#endif // USE_EPOLL
+
 int
 ccnl_io_loop(struct ccnl_relay_s *ccnl)
 {
-    int i, len, maxfd = -1, rc;
+    int i, maxfd = -1, rc;
     fd_set readfs, writefs;
-    unsigned char buf[CCNL_MAX_PACKET_SIZE];
-    
+
     if (ccnl->ifcount == 0) {
         DEBUGMSG(ERROR, "no socket to work with, not good, quitting\n");
         exit(EXIT_FAILURE);
     }
+    // from now on, ccnl_run_events() serves the relay's event queue
+    ccnl_timerq_select(ccnl->timerq);
+
+#ifdef USE_EPOLL
+    rc = epoll_create(CCNL_EPOLL_MAXEVENTS);
+    if (rc >= 0) {
+        int epfd = rc;
+
+        DEBUGMSG(INFO, "starting main event and IO loop (epoll)\n");
+        rc = ccnl_io_epoll_loop(ccnl, epfd);
+        close(epfd);
+        return rc;
+    }
+    DEBUGMSG(WARNING, "epoll_create: %s, falling back to select()\n",
+             strerror(errno));
+#endif
+
     for (i = 0; i < ccnl->ifcount; i++)
         if (ccnl->ifs[i].sock > maxfd)
             maxfd = ccnl->ifs[i].sock;
@@ -477,55 +907,59 @@ ccnl_io_loop(struct ccnl_relay_s *ccnl)
             if (ccnl->ifs[i].qlen > 0)
                 FD_SET(ccnl->ifs[i].sock, &writefs);
         }
+#ifdef USE_WORKERS
+        if (ccnl_worker_wakefd() >= 0) {
+            FD_SET(ccnl_worker_wakefd(), &readfs);
+            if (maxfd <= ccnl_worker_wakefd())
+                maxfd = ccnl_worker_wakefd() + 1;
+        }
+#endif
 
         timeout = ccnl_run_events();
+        for (i = 0; i < ccnl->ifcount; i++) {
+            ccnl_io_drain(ccnl, i);
+#ifdef USE_IOBATCH
+            if (ccnl_io_txpending(ccnl, i) > 0)
+                FD_SET(ccnl->ifs[i].sock, &writefs);
+#endif
+        }
+#ifdef USE_WORKERS
+        ccnl_worker_poll(ccnl);
+#endif
         rc = select(maxfd, &readfs, &writefs, NULL, timeout);
 
         if (rc < 0) {
+            if (errno == EINTR)
+                continue;
             perror("select(): ");
             exit(EXIT_FAILURE);
         }
+        ccnl_clock_tick();
 
 #ifdef USE_HTTP_STATUS
         ccnl_http_postselect(ccnl, ccnl->http, &readfs, &writefs);
 #endif
-        for (i = 0; i < ccnl->ifcount; i++) {
-            if (FD_ISSET(ccnl->ifs[i].sock, &readfs)) {
-                sockunion src_addr;
-                socklen_t addrlen = sizeof(sockunion);
-                if ((len = recvfrom(ccnl->ifs[i].sock, buf, sizeof(buf), 0,
-                                (struct sockaddr*) &src_addr, &addrlen)) > 0) {
-                    
-                    if (src_addr.sa.sa_family == AF_INET) {
-                        ccnl_core_RX(ccnl, i, buf, len,
-                                     &src_addr.sa, sizeof(src_addr.ip4));
-                    }
-#ifdef USE_ETHERNET
-                    else if (src_addr.sa.sa_family == AF_PACKET) {
-                        if (len > 14)
-                            ccnl_core_RX(ccnl, i, buf+14, len-14,
-                                         &src_addr.sa, sizeof(src_addr.eth));
-                    }
+#ifdef USE_WORKERS
+        if (ccnl_worker_wakefd() >= 0 &&
+                                FD_ISSET(ccnl_worker_wakefd(), &readfs))
+            ccnl_worker_RX(ccnl);
 #endif
-#ifdef USE_UNIXSOCKET
-                    else if (src_addr.sa.sa_family == AF_UNIX) {
-                        ccnl_core_RX(ccnl, i, buf, len,
-                                     &src_addr.sa, sizeof(src_addr.ux));
-                    }
-#endif
-                }
-            }
+        for (i = 0; i < ccnl->ifcount; i++) {
+            if (FD_ISSET(ccnl->ifs[i].sock, &readfs))
+                ccnl_io_recv(ccnl, i, CCNL_IO_BATCH);
 
-            if (FD_ISSET(ccnl->ifs[i].sock, &writefs)) {
-              ccnl_interface_CTS(ccnl, ccnl->ifs + i);
-            }
+            if (FD_ISSET(ccnl->ifs[i].sock, &writefs))
+                ccnl_io_drain(ccnl, i);
         }
     }
+#ifdef USE_IOBATCH
+    for (i = 0; i < ccnl->ifcount; i++)
+        ccnl_io_flush(ccnl, i);
+#endif
 
     return 0;
 }
 
-
 void
 ccnl_populate_cache(struct ccnl_relay_s *ccnl, char *path)
 {
@@ -627,7 +1061,7 @@ ccnl_populate_cache(struct ccnl_relay_s *ccnl, char *path)
                                                        typ != NDN_TLV_Data)
                 goto notacontent;
             pkt = ccnl_ndntlv_extract(data - buf->data, &data, &datalen,
-                                      0, 0, 0, 0, NULL, &prefix, NULL,
+                                      0, 0, 0, 0, 0, 0, NULL, &prefix, NULL,
                                       &nonce, &ppkd, &content, &contlen);
             break;
 #endif
@@ -643,6 +1077,8 @@ ccnl_populate_cache(struct ccnl_relay_s *ccnl, char *path)
             DEBUGMSG(WARNING, "missing prefix (%s)\n", de->d_name);
             goto Done;
         }
+        if (!ccnl_worker_owns(prefix)) // belongs to another worker's shard
+            goto Done;
 
         c = ccnl_content_new(ccnl, suite, &pkt, &prefix,
                              &ppkd, content, contlen);
@@ -672,19 +1108,37 @@ notacontent:
 int
 main(int argc, char **argv)
 {
+    struct ccnl_relay_s theRelay;
     int opt, max_cache_entries = -1, udpport = -1, httpport = -1;
+    int ifqlen = 0, k;
+    long max_cache_bytes = 0;
     char *datadir = NULL, *ethdev = NULL, *crypto_sock_path = NULL;
+    char *cachepolicy = NULL;
+#ifdef USE_WORKERS
+    int workers = 1;
+    char wuxpath[sizeof(((struct sockaddr_un*)0)->sun_path)];
+#endif
 #ifdef USE_UNIXSOCKET
     char *uxpath = CCNL_DEFAULT_UNIXSOCKNAME;
 #else
     char *uxpath = NULL;
 #endif
 
+    memset(&theRelay, 0, sizeof(theRelay));
     time(&theRelay.startup_time);
     srandom(time(NULL));
 
-    while ((opt = getopt(argc, argv, "hc:d:e:g:i:s:t:u:v:x:p:")) != -1) {
+#ifdef USE_WORKERS
+#  define WORKERS_OPT "w:"
+#else
+#  define WORKERS_OPT ""
+#endif
+    while ((opt = getopt(argc, argv, "hb:c:d:e:g:i:n:q:r:s:t:u:v:"
+                                     WORKERS_OPT "x:p:")) != -1) {
         switch (opt) {
+        case 'b':
+            max_cache_bytes = atol(optarg);
+            break;
         case 'c':
             max_cache_entries = atoi(optarg);
             break;
@@ -700,6 +1154,17 @@ main(int argc, char **argv)
         case 'i':
             inter_ccn_interval = atoi(optarg);
             break;
+        case 'n':
+            theRelay.max_nonces = atoi(optarg);
+            break;
+        case 'q':
+            ifqlen = atoi(optarg);
+            if (ifqlen <= 0)
+                goto usage;
+            break;
+        case 'r':
+            cachepolicy = optarg;
+            break;
         case 's':
             suite = ccnl_str2suite(optarg);
             if (suite < 0 || suite >= CCNL_SUITE_LAST)
@@ -719,6 +1184,11 @@ main(int argc, char **argv)
                 debug_level = ccnl_debug_str2level(optarg);
 #endif
             break;
+#ifdef USE_WORKERS
+        case 'w':
+            workers = atoi(optarg);
+            break;
+#endif
         case 'x':
             uxpath = optarg;
             break;
@@ -730,13 +1200,17 @@ main(int argc, char **argv)
 usage:
             fprintf(stderr,
                     "usage: %s [options]\n"
+                    "  -b MAX_CONTENT_BYTES\n"
                     "  -c MAX_CONTENT_ENTRIES\n"
                     "  -d databasedir\n"
                     "  -e ethdev\n"
                     "  -g MIN_INTER_PACKET_INTERVAL\n"
                     "  -h\n"
                     "  -i MIN_INTER_CCNMSG_INTERVAL\n"
+                    "  -n MAX_NONCES (for duplicate detection)\n"
                     "  -p crypto_face_ux_socket\n"
+                    "  -q IF_QUEUE_LEN (packets, default: 64)\n"
+                    "  -r CACHE_POLICY (lru, lfu, arc, wtinylfu)\n"
                     "  -s SUITE (ccnb, ccnx2014, iot2014, ndn2013)\n"
                     "  -t tcpport (for HTML status page)\n"
                     "  -u udpport\n"
@@ -744,6 +1218,9 @@ usage:
 #ifdef USE_LOGGING
                     "  -v DEBUG_LEVEL (fatal, error, warning, info, debug, trace, verbose)\n"
 #endif
+#ifdef USE_WORKERS
+                    "  -w WORKERS (processes, default: 1)\n"
+#endif
 #ifdef USE_UNIXSOCKET
                     "  -x unixpath\n"
 #endif
@@ -775,6 +1252,8 @@ usage:
     }
 
     ccnl_core_init();
+    theRelay.timerq = ccnl_timerq_new(); // NULL: use the thread's default
+    (void) ccnl_timerq_select(theRelay.timerq);
 
     DEBUGMSG(INFO, "This is ccn-lite-relay, starting at %s",
              ctime(&theRelay.startup_time) + 4);
@@ -783,15 +1262,47 @@ usage:
     DEBUGMSG(INFO, "  compile options: %s\n", compile_string());
     DEBUGMSG(INFO, "using suite %s\n", ccnl_suite2str(suite));
 
+#ifdef USE_WORKERS
+    if (workers > 1) {
+        if (ethdev) {
+            DEBUGMSG(WARNING, "no ethernet interface with several workers\n");
+            ethdev = NULL;
+        }
+        if (ccnl_worker_start(&theRelay, workers) < 0)
+            exit(EXIT_FAILURE);
+        if (ccnl_worker.self > 0) { // mgmt and status are served by worker 0
+            if (uxpath) {
+                snprintf(wuxpath, sizeof(wuxpath), "%s-%d",
+                         uxpath, ccnl_worker.self);
+                uxpath = wuxpath;
+            }
+            httpport = -1;
+        }
+    }
+#endif
+
     ccnl_relay_config(&theRelay, ethdev, udpport, httpport,
-                      uxpath, suite, max_cache_entries, crypto_sock_path);
+                      uxpath, suite, max_cache_entries, max_cache_bytes,
+                      crypto_sock_path);
+    for (k = 0; ifqlen && k < theRelay.ifcount; k++)
+        if (ccnl_interface_setqlen(theRelay.ifs + k, ifqlen))
+            exit(EXIT_FAILURE);
+    if (cachepolicy && ccnl_cache_setpolicy(&theRelay, cachepolicy))
+        exit(EXIT_FAILURE);
     if (datadir)
         ccnl_populate_cache(&theRelay, datadir);
     
     ccnl_io_loop(&theRelay);
 
-    while (eventqueue)
-        ccnl_rem_timer(eventqueue);
+#ifdef USE_IOBATCH
+    ccnl_io_batchstats(&theRelay);
+    ccnl_io_batchcleanup(&theRelay);
+#endif
+#ifdef USE_WORKERS
+    ccnl_worker_stop();
+#endif
+
+    ccnl_timer_cleanup();
     
     ccnl_core_cleanup(&theRelay);
 #ifdef USE_HTTP_STATUS
@@ -800,6 +1311,9 @@ usage:
 #ifdef USE_DEBUG_MALLOC
     debug_memdump();
 #endif
+#ifdef USE_MEMPOOL
+    ccnl_mempool_cleanup();
+#endif
 
     return 0;
 }
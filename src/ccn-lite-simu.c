@@ -31,6 +31,7 @@
 #define USE_DEBUG_MALLOC
 #define USE_ETHERNET
 //#define USE_FRAG
+#define USE_MEMPOOL
 #define USE_SCHEDULER
 #define USE_SUITE_CCNB
 #define USE_SUITE_CCNTLV
@@ -47,6 +48,7 @@
 
 void ccnl_core_addToCleanup(struct ccnl_buf_s *buf);
 
+#include "ccnl-ext-mempool.c"
 #include "ccnl-ext-debug.c"
 #include "ccnl-os-time.c"
 #include "ccnl-ext-logging.c"
@@ -329,15 +331,9 @@ ccnl_simu_defaultFaceScheduler(struct ccnl_relay_s *ccnl,
 }
 #endif
 
-void ccnl_ageing(void *relay, void *aux)
-{
-    ccnl_do_ageing(relay, aux);
-    ccnl_set_timer(1000000, ccnl_ageing, relay, 0);
-}
-
 void
 ccnl_simu_init_node(char node, const char *addr,
-                    int max_cache_entries)
+                    int max_cache_entries, char *cachepolicy)
 {
     struct ccnl_relay_s *relay = char2relay(node);
     struct ccnl_if_s *i;
@@ -346,6 +342,8 @@ ccnl_simu_init_node(char node, const char *addr,
 
     relay->id = relay - relays;
     relay->max_cache_entries = node == 'C' ? -1 : max_cache_entries;
+    if (cachepolicy)
+        ccnl_cache_setpolicy(relay, cachepolicy);
 
     // add (fake) eth0 interface with index 0:
     i = &relay->ifs[0];
@@ -373,8 +371,6 @@ ccnl_simu_init_node(char node, const char *addr,
             "/ccnl/simu/movie1" : "/ccnl/simu/movie2";
         relay->aux = (void *) client;
     }
-
-    ccnl_set_timer(1000000, ccnl_ageing, relay, 0);
 }
 
 
@@ -402,13 +398,12 @@ ccnl_simu_add_fwd(char node, const char *name, char dstnode)
     fwd->face->frag = ccnl_frag_new(CCNL_FRAG_CCNx2013, 1200);
 #endif
     fwd->face->flags |= CCNL_FACE_FLAGS_STATIC;
-    fwd->next = relay->fib;
-    relay->fib = fwd;
+    ccnl_fib_add(relay, fwd);
 }
 
 
 int
-ccnl_simu_init(int max_cache_entries)
+ccnl_simu_init(int max_cache_entries, char *cachepolicy)
 {
     static char dat[SIMU_CHUNK_SIZE];
     static char init_was_visited;
@@ -427,15 +422,15 @@ ccnl_simu_init(int max_cache_entries)
 
     // define each node's eth address:
     ccnl_simu_init_node('A', "\x00\x00\x00\x00\x00\x0a",
-                       max_cache_entries);
+                       max_cache_entries, cachepolicy);
     ccnl_simu_init_node('B', "\x00\x00\x00\x00\x00\x0b",
-                       max_cache_entries);
+                       max_cache_entries, cachepolicy);
     ccnl_simu_init_node('C', "\x00\x00\x00\x00\x00\x0c",
-                       max_cache_entries);
+                       max_cache_entries, cachepolicy);
     ccnl_simu_init_node('1', "\x00\x00\x00\x00\x00\x01",
-                       max_cache_entries);
+                       max_cache_entries, cachepolicy);
     ccnl_simu_init_node('2', "\x00\x00\x00\x00\x00\x02",
-                       max_cache_entries);
+                       max_cache_entries, cachepolicy);
 
     // install the system's forwarding pointers:
     ccnl_simu_add_fwd('A', "/ccnl/simu", '2');
@@ -484,10 +479,10 @@ void
 simu_eventloop()
 { 
     static struct timeval now;
+    struct ccnl_timer_s *t;
     long usec;
 
-    while (eventqueue) {
-        struct ccnl_timer_s *t = eventqueue;
+    while ((t = ccnl_timer_first())) {
         // printf("  looping now %g\n", CCNL_NOW());
         gettimeofday(&now, 0);
         usec = timevaldelta(&(t->timeout), &now);
@@ -498,21 +493,7 @@ simu_eventloop()
             ts.tv_nsec = 1000 * (usec % 1000000);
             nanosleep(&ts, NULL);
         }
-        t = eventqueue;
-        eventqueue = t->next;
-        if (t->fct) {
-            void (*fct)(char,int) = t->fct;
-            char c = t->node;
-            int i = t->intarg;
-            ccnl_free(t);
-            (fct)(c, i);
-        } else if (t->fct2) {
-            void (*fct2)(void*,void*) = t->fct2;
-            void *aux1 = t->aux1;
-            void *aux2 = t->aux2;
-            ccnl_free(t);
-            (fct2)(aux1, aux2);
-        }
+        ccnl_timer_fire(ccnl_timer_first());
     }
     DEBUGMSG(ERROR, "simu event loop: no more events to handle\n");
 }
@@ -534,8 +515,7 @@ ccnl_simu_cleanup(void *dummy, void *dummy2)
         ccnl_core_cleanup(relay);
     }
 
-    while(eventqueue)
-        ccnl_rem_timer(eventqueue);
+    ccnl_timer_cleanup();
 
     while(etherqueue) {
         struct ccnl_ethernet_s *e = etherqueue->next;
@@ -549,6 +529,9 @@ ccnl_simu_cleanup(void *dummy, void *dummy2)
 #ifdef USE_DEBUG_MALLOC
     debug_memdump();
 #endif
+#ifdef USE_MEMPOOL
+    ccnl_mempool_cleanup();
+#endif
 }
 
 // ----------------------------------------------------------------------
@@ -558,11 +541,12 @@ main(int argc, char **argv)
 {
     int opt;
     int max_cache_entries = CCNL_DEFAULT_MAX_CACHE_ENTRIES;
+    char *cachepolicy = NULL;
 
     //    srand(time(NULL));
     srandom(time(NULL));
 
-    while ((opt = getopt(argc, argv, "hc:g:i:s:v:")) != -1) {
+    while ((opt = getopt(argc, argv, "hc:g:i:r:s:v:")) != -1) {
         switch (opt) {
         case 'c':
             max_cache_entries = atoi(optarg);
@@ -573,6 +557,9 @@ main(int argc, char **argv)
         case 'i':
             inter_ccn_interval = atoi(optarg);
             break;
+        case 'r':
+            cachepolicy = optarg;
+            break;
         case 'v':
             if (isdigit(optarg[0]))
                 debug_level = atoi(optarg);
@@ -588,6 +575,7 @@ main(int argc, char **argv)
             fprintf(stderr, "Xusage: %s [-h] [-c MAX_CONTENT_ENTRIES] "
                     "[-g MIN_INTER_PACKET_INTERVAL] "
                     "[-i MIN_INTER_CCNMSG_INTERVAL] "
+                    "[-r CACHE_POLICY (lru, lfu, arc, wtinylfu)] "
                     "[-s SUITE (ccnb, ccnx2014, iot2014, ndn2013)] "
                     "[-v DEBUG_LEVEL]\n",
                     argv[0]);
@@ -606,7 +594,7 @@ main(int argc, char **argv)
     DEBUGMSG(INFO, "  compile options: %s\n", compile_string());
     DEBUGMSG(INFO, "using suite %s\n", ccnl_suite2str(theSuite));
 
-    ccnl_simu_init(max_cache_entries);
+    ccnl_simu_init(max_cache_entries, cachepolicy);
 
     DEBUGMSG(INFO, "simulation starts\n");
     simu_eventloop();
@@ -0,0 +1,551 @@
+/*
+ * @f ccnl-core-cache.c
+ * @b CCN lite, replacement policies for the content store
+ *
+ * Copyright (C) 2026, the CCN-lite contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ * File history:
+ * 2026-10-17 created, LRU list moved here from ccnl-core.c,
+ *            added LFU, ARC and W-TinyLFU
+ */
+
+// The content store asks the policy for a victim whenever it is full.
+// Every policy keeps the evictable (non static) content in one or more
+// of the lists below, each ordered from most to least recently used.
+// The name hash of a content object (c->cslink.hash) serves as its key.
+
+struct ccnl_cslist_s {
+    struct ccnl_content_s *first, *last;
+    int cnt;
+};
+
+// name hash of a recently evicted content object (ARC's ghost lists)
+struct ccnl_csghost_s {
+    struct ccnl_hashlink_s link;
+    struct ccnl_csghost_s *next, *prev;
+    int list;
+};
+
+struct ccnl_cachestate_s {
+    struct ccnl_cachepolicy_s *policy;
+    struct ccnl_cslist_s list[CCNL_CACHE_LISTS];
+    // ARC:
+    struct ccnl_csghost_s *ghost[2], *ghostend[2];
+    int ghostcnt[2];
+    struct ccnl_hashtab_s ghostidx;
+    int arc_p;          // target size of the recency list T1
+    int arc_from;       // ghost list the incoming name was found in, or -1
+    // W-TinyLFU:
+    unsigned char *sketch; // count-min sketch, CCNL_CACHE_SKETCHROWS rows
+    int sketchwidth;    // counters per row (power of two)
+    int sketchadds;     // increments since the last halving
+};
+
+struct ccnl_cachepolicy_s {
+    char *name;
+    int (*init)(struct ccnl_relay_s *ccnl);
+    void (*cleanup)(struct ccnl_relay_s *ccnl);
+    // called before making room for c (which is not yet in the cache)
+    void (*admit)(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c);
+    struct ccnl_content_s* (*victim)(struct ccnl_relay_s *ccnl);
+    void (*insert)(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c);
+    void (*hit)(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c);
+    void (*remove)(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c);
+};
+
+// ----------------------------------------------------------------------
+// list helpers
+
+static void
+ccnl_cslist_unlink(struct ccnl_cachestate_s *s, struct ccnl_content_s *c)
+{
+    struct ccnl_cslist_s *l;
+
+    if (!c->cslist)
+        return;
+    l = s->list + c->cslist - 1;
+    if (c->cslprev)
+        c->cslprev->cslnext = c->cslnext;
+    else
+        l->first = c->cslnext;
+    if (c->cslnext)
+        c->cslnext->cslprev = c->cslprev;
+    else
+        l->last = c->cslprev;
+    l->cnt--;
+    c->cslnext = c->cslprev = NULL;
+    c->cslist = 0;
+}
+
+static void
+ccnl_cslist_push(struct ccnl_cachestate_s *s, int n,
+                 struct ccnl_content_s *c)
+{
+    struct ccnl_cslist_s *l = s->list + n;
+
+    ccnl_cslist_unlink(s, c);
+    c->cslprev = NULL;
+    c->cslnext = l->first;
+    if (l->first)
+        l->first->cslprev = c;
+    else
+        l->last = c;
+    l->first = c;
+    l->cnt++;
+    c->cslist = n + 1;
+}
+
+// the number of entries the policy should plan for
+static int
+ccnl_cache_capacity(struct ccnl_relay_s *ccnl)
+{
+    if (ccnl->max_cache_entries > 0)
+        return ccnl->max_cache_entries;
+    return ccnl->contentcnt > 0 ? ccnl->contentcnt : 1;
+}
+
+// ----------------------------------------------------------------------
+// LRU: a single list
+
+static void
+ccnl_cache_lru_insert(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c)
+{
+    ccnl_cslist_push(ccnl->cachestate, 0, c);
+}
+
+// move c to the front of its list
+static void
+ccnl_cache_touch(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c)
+{
+    if (c->cslist)
+        ccnl_cslist_push(ccnl->cachestate, c->cslist - 1, c);
+}
+
+static void
+ccnl_cache_unlink(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c)
+{
+    ccnl_cslist_unlink(ccnl->cachestate, c);
+}
+
+static struct ccnl_content_s*
+ccnl_cache_lru_victim(struct ccnl_relay_s *ccnl)
+{
+    return ccnl->cachestate->list[0].last;
+}
+
+// ----------------------------------------------------------------------
+// LFU: one list per use count (saturating at CCNL_CACHE_LISTS-1),
+// least recently used first within the same count
+
+static void
+ccnl_cache_lfu_insert(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c)
+{
+    c->freq = 0;
+    ccnl_cslist_push(ccnl->cachestate, 0, c);
+}
+
+static void
+ccnl_cache_lfu_hit(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c)
+{
+    if (!c->cslist)
+        return;
+    if (c->freq < CCNL_CACHE_LISTS - 1)
+        c->freq++;
+    ccnl_cslist_push(ccnl->cachestate, c->freq, c);
+}
+
+static struct ccnl_content_s*
+ccnl_cache_lfu_victim(struct ccnl_relay_s *ccnl)
+{
+    struct ccnl_cachestate_s *s = ccnl->cachestate;
+    int i;
+
+    for (i = 0; i < CCNL_CACHE_LISTS; i++)
+        if (s->list[i].last)
+            return s->list[i].last;
+    return NULL;
+}
+
+// ----------------------------------------------------------------------
+// ARC (Megiddo and Modha, FAST'03): T1 (list 0) holds content seen once,
+// T2 (list 1) content hit at least twice. The ghost lists B1 and B2
+// remember the names recently evicted from T1 and T2 and steer the
+// target size arc_p of T1.
+
+static void
+ccnl_cache_ghost_remove(struct ccnl_cachestate_s *s, struct ccnl_csghost_s *g)
+{
+    DBL_LINKED_LIST_REMOVE(s->ghost[g->list], g);
+    if (s->ghostend[g->list] == g)
+        s->ghostend[g->list] = g->prev;
+    s->ghostcnt[g->list]--;
+    ccnl_hashtab_remove(&s->ghostidx, &g->link);
+    ccnl_free(g);
+}
+
+static void
+ccnl_cache_ghost_add(struct ccnl_cachestate_s *s, int list,
+                     unsigned int hash)
+{
+    struct ccnl_csghost_s *g;
+
+    g = (struct ccnl_csghost_s*) ccnl_calloc(1, sizeof(*g));
+    if (!g)
+        return;
+    g->list = list;
+    DBL_LINKED_LIST_ADD(s->ghost[list], g);
+    if (!s->ghostend[list])
+        s->ghostend[list] = g;
+    s->ghostcnt[list]++;
+    ccnl_hashtab_add(&s->ghostidx, &g->link, hash, g);
+}
+
+static void
+ccnl_cache_arc_cleanup(struct ccnl_relay_s *ccnl)
+{
+    struct ccnl_cachestate_s *s = ccnl->cachestate;
+
+    while (s->ghost[0])
+        ccnl_cache_ghost_remove(s, s->ghost[0]);
+    while (s->ghost[1])
+        ccnl_cache_ghost_remove(s, s->ghost[1]);
+    ccnl_hashtab_cleanup(&s->ghostidx);
+}
+
+static void
+ccnl_cache_arc_admit(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c)
+{
+    struct ccnl_cachestate_s *s = ccnl->cachestate;
+    struct ccnl_hashlink_s *l;
+    struct ccnl_csghost_s *g;
+    int b1 = s->ghostcnt[0], b2 = s->ghostcnt[1];
+
+    s->arc_from = -1;
+    for (l = ccnl_hashtab_first(&s->ghostidx, c->cslink.hash); l;
+                                                l = ccnl_hashtab_next(l)) {
+        g = (struct ccnl_csghost_s*) l->obj;
+        s->arc_from = g->list;
+        if (g->list == 0)
+            s->arc_p += b1 >= b2 ? 1 : b2 / b1;
+        else
+            s->arc_p -= b2 >= b1 ? 1 : b1 / b2;
+        ccnl_cache_ghost_remove(s, g);
+        break;
+    }
+    if (s->arc_p > ccnl_cache_capacity(ccnl))
+        s->arc_p = ccnl_cache_capacity(ccnl);
+    if (s->arc_p < 0)
+        s->arc_p = 0;
+}
+
+static struct ccnl_content_s*
+ccnl_cache_arc_victim(struct ccnl_relay_s *ccnl)
+{
+    struct ccnl_cachestate_s *s = ccnl->cachestate;
+    int t1 = s->list[0].cnt;
+
+    if (t1 > 0 && (t1 > s->arc_p || (s->arc_from == 1 && t1 == s->arc_p)))
+        return s->list[0].last;
+    return s->list[1].last ? s->list[1].last : s->list[0].last;
+}
+
+static void
+ccnl_cache_arc_insert(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c)
+{
+    struct ccnl_cachestate_s *s = ccnl->cachestate;
+    int cap = ccnl_cache_capacity(ccnl);
+
+    // names coming back from a ghost list were used at least twice
+    ccnl_cslist_push(s, s->arc_from >= 0 ? 1 : 0, c);
+    s->arc_from = -1;
+
+    while (s->ghostcnt[0] && s->list[0].cnt + s->ghostcnt[0] > cap)
+        ccnl_cache_ghost_remove(s, s->ghostend[0]);
+    while (s->ghostcnt[1] && s->list[0].cnt + s->list[1].cnt +
+                             s->ghostcnt[0] + s->ghostcnt[1] > 2 * cap)
+        ccnl_cache_ghost_remove(s, s->ghostend[1]);
+}
+
+static void
+ccnl_cache_arc_hit(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c)
+{
+    if (c->cslist)
+        ccnl_cslist_push(ccnl->cachestate, 1, c);
+}
+
+static void
+ccnl_cache_arc_remove(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c)
+{
+    int list = c->cslist - 1;
+
+    if (list < 0)
+        return;
+    ccnl_cslist_unlink(ccnl->cachestate, c);
+    ccnl_cache_ghost_add(ccnl->cachestate, list, c->cslink.hash);
+}
+
+// ----------------------------------------------------------------------
+// W-TinyLFU (Einziger et al., ACM ToS 2017): new content enters a small
+// LRU window (list 0). Content leaving the window only replaces the
+// victim of the main segmented LRU (probation: list 1, protected: list 2)
+// if a count-min sketch of the recent accesses rates it more popular.
+
+#define CCNL_TINYLFU_WINDOW     0
+#define CCNL_TINYLFU_PROBATION  1
+#define CCNL_TINYLFU_PROTECTED  2
+
+static unsigned char*
+ccnl_cache_sketch_counter(struct ccnl_cachestate_s *s, int row,
+                          unsigned int hash)
+{
+    static unsigned int seed[] = { 0x9e3779b1u, 0x85ebca77u,
+                                   0xc2b2ae3du, 0x27d4eb2fu };
+
+    hash *= seed[row % 4];
+    hash ^= hash >> 15;
+    return s->sketch + row * s->sketchwidth + (hash & (s->sketchwidth - 1));
+}
+
+static void
+ccnl_cache_sketch_add(struct ccnl_cachestate_s *s, unsigned int hash)
+{
+    unsigned char *cnt;
+    int i;
+
+    for (i = 0; i < CCNL_CACHE_SKETCHROWS; i++) {
+        cnt = ccnl_cache_sketch_counter(s, i, hash);
+        if (*cnt < 15)
+            (*cnt)++;
+    }
+    // ageing: halve all counters after 10 increments per counter
+    if (++s->sketchadds >= 10 * s->sketchwidth) {
+        for (i = 0; i < CCNL_CACHE_SKETCHROWS * s->sketchwidth; i++)
+            s->sketch[i] >>= 1;
+        s->sketchadds = 0;
+    }
+}
+
+static int
+ccnl_cache_sketch_estimate(struct ccnl_cachestate_s *s, unsigned int hash)
+{
+    int i, cnt, min = 15;
+
+    for (i = 0; i < CCNL_CACHE_SKETCHROWS; i++) {
+        cnt = *ccnl_cache_sketch_counter(s, i, hash);
+        if (cnt < min)
+            min = cnt;
+    }
+    return min;
+}
+
+static int
+ccnl_cache_tinylfu_init(struct ccnl_relay_s *ccnl)
+{
+    struct ccnl_cachestate_s *s = ccnl->cachestate;
+
+    for (s->sketchwidth = CCNL_CACHE_SKETCHMIN;
+         s->sketchwidth < ccnl->max_cache_entries; s->sketchwidth *= 2);
+    s->sketch = ccnl_calloc(CCNL_CACHE_SKETCHROWS, s->sketchwidth);
+    return s->sketch ? 0 : -1;
+}
+
+static void
+ccnl_cache_tinylfu_cleanup(struct ccnl_relay_s *ccnl)
+{
+    ccnl_free(ccnl->cachestate->sketch);
+}
+
+static void
+ccnl_cache_tinylfu_insert(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c)
+{
+    struct ccnl_cachestate_s *s = ccnl->cachestate;
+    int window = ccnl_cache_capacity(ccnl) / 100;
+
+    ccnl_cache_sketch_add(s, c->cslink.hash);
+    ccnl_cslist_push(s, CCNL_TINYLFU_WINDOW, c);
+    // while the cache fills up, the window's overflow goes straight
+    // to probation
+    while (s->list[CCNL_TINYLFU_WINDOW].cnt > (window > 0 ? window : 1))
+        ccnl_cslist_push(s, CCNL_TINYLFU_PROBATION,
+                         s->list[CCNL_TINYLFU_WINDOW].last);
+}
+
+static void
+ccnl_cache_tinylfu_hit(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c)
+{
+    struct ccnl_cachestate_s *s = ccnl->cachestate;
+    int protect;
+
+    ccnl_cache_sketch_add(s, c->cslink.hash);
+    switch (c->cslist - 1) {
+    case CCNL_TINYLFU_WINDOW:
+    case CCNL_TINYLFU_PROTECTED:
+        ccnl_cslist_push(s, c->cslist - 1, c);
+        break;
+    case CCNL_TINYLFU_PROBATION:
+        ccnl_cslist_push(s, CCNL_TINYLFU_PROTECTED, c);
+        // the protected segment takes up to 80% of the main cache
+        protect = (ccnl_cache_capacity(ccnl) * 8) / 10;
+        while (s->list[CCNL_TINYLFU_PROTECTED].cnt > protect)
+            ccnl_cslist_push(s, CCNL_TINYLFU_PROBATION,
+                             s->list[CCNL_TINYLFU_PROTECTED].last);
+        break;
+    default:
+        break;
+    }
+}
+
+static struct ccnl_content_s*
+ccnl_cache_tinylfu_victim(struct ccnl_relay_s *ccnl)
+{
+    struct ccnl_cachestate_s *s = ccnl->cachestate;
+    struct ccnl_content_s *cand, *victim;
+
+    victim = s->list[CCNL_TINYLFU_PROBATION].last;
+    if (!victim)
+        victim = s->list[CCNL_TINYLFU_PROTECTED].last;
+    cand = s->list[CCNL_TINYLFU_WINDOW].last;
+    if (!cand)
+        return victim;
+    if (!victim)
+        return cand;
+    // admission filter: the window's LRU entry has to beat the main victim
+    if (ccnl_cache_sketch_estimate(s, cand->cslink.hash) >
+                        ccnl_cache_sketch_estimate(s, victim->cslink.hash)) {
+        ccnl_cslist_push(s, CCNL_TINYLFU_PROBATION, cand);
+        return victim;
+    }
+    return cand;
+}
+
+// ----------------------------------------------------------------------
+
+static struct ccnl_cachepolicy_s ccnl_cachepolicies[] = {
+    {"lru", NULL, NULL, NULL, ccnl_cache_lru_victim,
+     ccnl_cache_lru_insert, ccnl_cache_touch, ccnl_cache_unlink},
+    {"lfu", NULL, NULL, NULL, ccnl_cache_lfu_victim,
+     ccnl_cache_lfu_insert, ccnl_cache_lfu_hit, ccnl_cache_unlink},
+    {"arc", NULL, ccnl_cache_arc_cleanup, ccnl_cache_arc_admit,
+     ccnl_cache_arc_victim, ccnl_cache_arc_insert, ccnl_cache_arc_hit,
+     ccnl_cache_arc_remove},
+    {"wtinylfu", ccnl_cache_tinylfu_init, ccnl_cache_tinylfu_cleanup, NULL,
+     ccnl_cache_tinylfu_victim, ccnl_cache_tinylfu_insert,
+     ccnl_cache_tinylfu_hit, ccnl_cache_unlink},
+    {NULL}
+};
+
+void
+ccnl_cache_cleanup(struct ccnl_relay_s *ccnl)
+{
+    struct ccnl_content_s *c;
+
+    if (!ccnl->cachestate)
+        return;
+    for (c = ccnl->contents; c; c = c->next)
+        c->cslist = 0;
+    if (ccnl->cachestate->policy->cleanup)
+        ccnl->cachestate->policy->cleanup(ccnl);
+    ccnl_free(ccnl->cachestate);
+    ccnl->cachestate = NULL;
+}
+
+// selects the replacement policy by name (NULL: LRU), returns 0 on success
+int
+ccnl_cache_setpolicy(struct ccnl_relay_s *ccnl, char *name)
+{
+    struct ccnl_cachepolicy_s *p = ccnl_cachepolicies;
+    struct ccnl_content_s *c;
+
+    if (name)
+        for (; p->name && strcmp(p->name, name); p++);
+    if (!p->name) {
+        DEBUGMSG(ERROR, "unknown cache replacement policy %s\n", name);
+        return -1;
+    }
+    ccnl_cache_cleanup(ccnl);
+    ccnl->cachestate = (struct ccnl_cachestate_s*)
+        ccnl_calloc(1, sizeof(struct ccnl_cachestate_s));
+    if (!ccnl->cachestate)
+        return -1;
+    ccnl->cachestate->policy = p;
+    ccnl->cachestate->arc_from = -1;
+    if (p->init && p->init(ccnl)) {
+        ccnl_free(ccnl->cachestate);
+        ccnl->cachestate = NULL;
+        return -1;
+    }
+    for (c = ccnl->contents; c; c = c->next)
+        if (!(c->flags & CCNL_CONTENT_FLAGS_STATIC))
+            p->insert(ccnl, c);
+    DEBUGMSG(INFO, "cache replacement policy: %s\n", p->name);
+    return 0;
+}
+
+char*
+ccnl_cache_policyname(struct ccnl_relay_s *ccnl)
+{
+    return ccnl->cachestate ? ccnl->cachestate->policy->name : "lru";
+}
+
+// ----------------------------------------------------------------------
+// entry points for the content store (see ccnl-core.c)
+
+static void
+ccnl_cache_admit(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c)
+{
+    if (!ccnl->cachestate && ccnl_cache_setpolicy(ccnl, NULL))
+        return;
+    if (ccnl->cachestate->policy->admit)
+        ccnl->cachestate->policy->admit(ccnl, c);
+}
+
+// returns the content to evict, or NULL if only static content is left
+static struct ccnl_content_s*
+ccnl_cache_victim(struct ccnl_relay_s *ccnl)
+{
+    struct ccnl_content_s *c;
+
+    if (!ccnl->cachestate)
+        return NULL;
+    // static content is never evicted: drop it from the policy's lists
+    // when it is proposed
+    while ((c = ccnl->cachestate->policy->victim(ccnl)) &&
+           (c->flags & CCNL_CONTENT_FLAGS_STATIC))
+        ccnl_cslist_unlink(ccnl->cachestate, c);
+    return c;
+}
+
+static void
+ccnl_cache_insert(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c)
+{
+    if (ccnl->cachestate)
+        ccnl->cachestate->policy->insert(ccnl, c);
+}
+
+static void
+ccnl_cache_hit(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c)
+{
+    if (ccnl->cachestate && !(c->flags & CCNL_CONTENT_FLAGS_STATIC))
+        ccnl->cachestate->policy->hit(ccnl, c);
+}
+
+static void
+ccnl_cache_remove(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c)
+{
+    if (ccnl->cachestate && c->cslist)
+        ccnl->cachestate->policy->remove(ccnl, c);
+}
+
+// eof
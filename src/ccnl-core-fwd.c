@@ -75,6 +75,8 @@ ccnl_ccnb_fwd(struct ccnl_relay_s *ccnl, struct ccnl_face_s *from,
         DEBUGMSG(DEBUG, "  parsing error or no prefix\n");
         goto Done;
     }
+    if (ccnl_worker_steer(ccnl, from, CCNL_SUITE_CCNB, p, buf))
+        goto Skip;
     if (nonce && ccnl_nonce_find_or_append(ccnl, nonce)) {
         DEBUGMSG(DEBUG, "  dropped because of duplicate nonce\n");
         goto Skip;
@@ -89,17 +91,17 @@ ccnl_ccnb_fwd(struct ccnl_relay_s *ccnl, struct ccnl_face_s *from,
         }
         // CONFORM: Step 1:
         if ( aok & 0x01 ) { // honor "answer-from-existing-content-store" flag
-            for (c = ccnl->contents; c; c = c->next) {
-                if (c->suite != CCNL_SUITE_CCNB) continue;
-                if (!ccnl_i_prefixof_c(p, minsfx, maxsfx, c)) continue;
-                if (ppkd && !buf_equal(ppkd, c->details.ccnb.ppkd)) continue;
-                // FIXME: should check stale bit in aok here
+            // only answer with stale content if aok allows it (0x04)
+            c = ccnl_cstrie_lookup(ccnl, CCNL_SUITE_CCNB, p, minsfx, maxsfx,
+                                   !(aok & 0x04), ppkd);
+            if (c) {
                 DEBUGMSG(DEBUG, "  matching content for interest, content %p\n",
                          (void *) c);
+                ccnl_content_used(ccnl, c);
                 if (from->ifndx >= 0) {
                     ccnl_nfn_monitor(ccnl, from, c->name, c->content,
                                      c->contentlen);
-                    ccnl_face_enqueue(ccnl, from, buf_dup(c->pkt));
+                    ccnl_face_enqueue(ccnl, from, ccnl_buf_ref(c->pkt));
                 } else {
                     ccnl_app_RX(ccnl, c);
                 }
@@ -107,10 +109,9 @@ ccnl_ccnb_fwd(struct ccnl_relay_s *ccnl, struct ccnl_face_s *from,
             }
         }
         // CONFORM: Step 2: check whether interest is already known
-        for (i = ccnl->pit; i; i = i->next) {
-            if (i->suite == CCNL_SUITE_CCNB &&
-                !ccnl_prefix_cmp(i->prefix, NULL, p, CMP_EXACT) &&
-                i->details.ccnb.minsuffix == minsfx &&
+        for (i = ccnl_pit_find(ccnl, NULL, CCNL_SUITE_CCNB, p); i;
+                           i = ccnl_pit_find(ccnl, i, CCNL_SUITE_CCNB, p)) {
+            if (i->details.ccnb.minsuffix == minsfx &&
                 i->details.ccnb.maxsuffix == maxsfx && 
                 ((!ppkd && !i->details.ccnb.ppkd) ||
                    buf_equal(ppkd, i->details.ccnb.ppkd)) )
@@ -133,13 +134,14 @@ ccnl_ccnb_fwd(struct ccnl_relay_s *ccnl, struct ccnl_face_s *from,
                 i->details.ccnb.ppkd = ppkd, ppkd = NULL;
             if (i) { // CONFORM: Step 3 (and 4)
                 DEBUGMSG(DEBUG, "  created new interest entry %p\n", (void *)i);
-                if (scope > 2)
-                    ccnl_interest_propagate(ccnl, i);
+                if (scope > 2 && ccnl_interest_propagate(ccnl, i))
+                    i = NULL;
             }
         } else if (scope > 2 && (from->flags & CCNL_FACE_FLAGS_FWDALLI)) {
             DEBUGMSG(DEBUG, "  old interest, nevertheless propagated %p\n",
                      (void *) i);
-            ccnl_interest_propagate(ccnl, i);
+            if (ccnl_interest_propagate(ccnl, i))
+                i = NULL;
         }
         if (i) { // store the I request, for the incoming face (Step 3)
             DEBUGMSG(DEBUG, "  appending interest entry %p\n", (void *) i);
@@ -158,9 +160,8 @@ ccnl_ccnb_fwd(struct ccnl_relay_s *ccnl, struct ccnl_face_s *from,
 #endif /*USE_SIGNATURES*/
 
         // CONFORM: Step 1:
-        for (c = ccnl->contents; c; c = c->next)
-            if (buf_equal(c->pkt, buf))
-                goto Skip; // content is dup
+        if (ccnl_cs_findpkt(ccnl, CCNL_SUITE_CCNB, p, buf))
+            goto Skip; // content is dup
         c = ccnl_content_new(ccnl, CCNL_SUITE_CCNB,
                              &buf, &p, &ppkd, content, contlen);
         ccnl_fwd_handleContent(ccnl, from, c);
@@ -238,23 +239,23 @@ ccnl_ccntlv_fwd(struct ccnl_relay_s *relay, struct ccnl_face_s *from,
             DEBUGMSG(DEBUG, "  parsing error or no prefix\n");
             goto Done;
     }
+    if (ccnl_worker_steer(relay, from, CCNL_SUITE_CCNTLV, p, buf))
+        goto Skip;
 
     if (typ == CCNX_PT_Interest) {
         DEBUGMSG(DEBUG, "  interest=<%s>\n", ccnl_prefix_to_path(p));
         // CONFORM: Step 1: search for matching local content
-        for (c = relay->contents; c; c = c->next) {
-            if (c->suite != CCNL_SUITE_CCNTLV)
-                continue;
+        for (c = ccnl_cs_find(relay, NULL, CCNL_SUITE_CCNTLV, p); c;
+                             c = ccnl_cs_find(relay, c, CCNL_SUITE_CCNTLV, p)) {
             // TODO: check keyid
             // TODO: check freshness, kind-of-reply
-            if (ccnl_prefix_cmp(c->name, NULL, p, CMP_EXACT))
-                continue;
             DEBUGMSG(DEBUG, "  matching content for interest, content %p\n",
                      (void *) c);
+            ccnl_content_used(relay, c);
             if (from->ifndx >= 0){
                 ccnl_nfn_monitor(relay, from, c->name, c->content,
                                  c->contentlen);
-                ccnl_face_enqueue(relay, from, buf_dup(c->pkt));
+                ccnl_face_enqueue(relay, from, ccnl_buf_ref(c->pkt));
             } else {
                 ccnl_app_RX(relay, c);
             }
@@ -262,13 +263,8 @@ ccnl_ccntlv_fwd(struct ccnl_relay_s *relay, struct ccnl_face_s *from,
         }
         DEBUGMSG(DEBUG, "  no matching content for interest\n");
         // CONFORM: Step 2: check whether interest is already known
-        for (i = relay->pit; i; i = i->next) {
-            if (i->suite != CCNL_SUITE_CCNTLV)
-                continue;
-            if (!ccnl_prefix_cmp(i->prefix, NULL, p, CMP_EXACT))
-                // TODO check keyid
-                break;
-        }
+        i = ccnl_pit_find(relay, NULL, CCNL_SUITE_CCNTLV, p);
+        // TODO check keyid
         // this is a new/unknown I request: create and propagate
 #ifdef USE_NFN
         if (!i && ccnl_nfnprefix_isNFN(p)) { // NFN PLUGIN CALL
@@ -284,12 +280,14 @@ ccnl_ccntlv_fwd(struct ccnl_relay_s *relay, struct ccnl_face_s *from,
                 // TODO keyID restriction
                 DEBUGMSG(DEBUG, "  created new interest entry %p\n",
                          (void *) i);
-                ccnl_interest_propagate(relay, i);
+                if (ccnl_interest_propagate(relay, i))
+                    i = NULL;
             }
         } else if ((from->flags & CCNL_FACE_FLAGS_FWDALLI)) {
             DEBUGMSG(DEBUG, "  old interest, nevertheless propagated %p\n",
                      (void *) i);
-            ccnl_interest_propagate(relay, i);
+            if (ccnl_interest_propagate(relay, i))
+                i = NULL;
         }
         if (i) { // store the I request, for the incoming face (Step 3)
             DEBUGMSG(DEBUG, "  appending interest entry %p\n", (void *) i);
@@ -301,9 +299,8 @@ ccnl_ccntlv_fwd(struct ccnl_relay_s *relay, struct ccnl_face_s *from,
         DEBUGMSG(DEBUG, "  data=<%s>\n", ccnl_prefix_to_path(p));
 
         // CONFORM: Step 1:
-        for (c = relay->contents; c; c = c->next)
-            if (buf_equal(c->pkt, buf))
-                goto Skip; // content is dup
+        if (ccnl_cs_findpkt(relay, CCNL_SUITE_CCNTLV, p, buf))
+            goto Skip; // content is dup
         c = ccnl_content_new(relay, CCNL_SUITE_CCNTLV,
                              &buf, &p, NULL, content, contlen);
         ccnl_fwd_handleContent(relay, from, c);
@@ -392,18 +389,18 @@ ccnl_iottlv_forwarder(struct ccnl_relay_s *relay, struct ccnl_face_s *from,
         DEBUGMSG(WARNING, "  parsing error or no prefix\n");
         goto Done;
     }
+    if (ccnl_worker_steer(relay, from, CCNL_SUITE_IOTTLV, p, buf))
+        goto Skip;
 
     if (typ == IOT_TLV_Request) {
         DEBUGMSG(DEBUG, "  request=<%s>\n", ccnl_prefix_to_path(p));
-        for (c = relay->contents; c; c = c->next) {
-            if (c->suite != CCNL_SUITE_IOTTLV)
-                continue;
-            if (ccnl_prefix_cmp(c->name, NULL, p, CMP_EXACT))
-                continue;
+        for (c = ccnl_cs_find(relay, NULL, CCNL_SUITE_IOTTLV, p); c;
+                             c = ccnl_cs_find(relay, c, CCNL_SUITE_IOTTLV, p)) {
             DEBUGMSG(DEBUG, "  matching content for interest, content %p\n", (void *) c);
+            ccnl_content_used(relay, c);
             if (from->ifndx >= 0) {
                 ccnl_nfn_monitor(relay, from, c->name, c->content, c->contentlen);
-                ccnl_face_enqueue(relay, from, buf_dup(c->pkt));
+                ccnl_face_enqueue(relay, from, ccnl_buf_ref(c->pkt));
             } else {
                 ccnl_app_RX(relay, c);
             }
@@ -411,11 +408,7 @@ ccnl_iottlv_forwarder(struct ccnl_relay_s *relay, struct ccnl_face_s *from,
         }
         DEBUGMSG(DEBUG, "  no matching content for interest\n");
         // CONFORM: Step 2: check whether interest is already known
-        for (i = relay->pit; i; i = i->next) {
-            if (i->suite == CCNL_SUITE_IOTTLV &&
-                !ccnl_prefix_cmp(i->prefix, NULL, p, CMP_EXACT))
-                break;
-        }
+        i = ccnl_pit_find(relay, NULL, CCNL_SUITE_IOTTLV, p);
         // this is a new/unknown I request: create and propagate
 #ifdef USE_NFN
         if (!i && ccnl_nfnprefix_isNFN(p)) { // NFN PLUGIN CALL
@@ -432,11 +425,13 @@ ccnl_iottlv_forwarder(struct ccnl_relay_s *relay, struct ccnl_face_s *from,
                                   &buf, &p, 0, 0);
             if (i) { // CONFORM: Step 3 (and 4)
                 DEBUGMSG(DEBUG, "  created new interest entry %p\n", (void *) i);
-                ccnl_interest_propagate(relay, i);
+                if (ccnl_interest_propagate(relay, i))
+                    i = NULL;
             }
         } else if (from->flags & CCNL_FACE_FLAGS_FWDALLI) {
             DEBUGMSG(DEBUG, "  old interest, nevertheless propagated %p\n", (void *) i);
-            ccnl_interest_propagate(relay, i);
+            if (ccnl_interest_propagate(relay, i))
+                i = NULL;
         }
         if (i) { // store the I request, for the incoming face (Step 3)
             DEBUGMSG(DEBUG, "  appending interest entry %p\n", (void *) i);
@@ -456,9 +451,8 @@ ccnl_iottlv_forwarder(struct ccnl_relay_s *relay, struct ccnl_face_s *from,
 */
         
         // CONFORM: Step 1:
-        for (c = relay->contents; c; c = c->next)
-            if (buf_equal(c->pkt, buf))
-                goto Skip; // content is dup
+        if (ccnl_cs_findpkt(relay, CCNL_SUITE_IOTTLV, p, buf))
+            goto Skip; // content is dup
         c = ccnl_content_new(relay, CCNL_SUITE_IOTTLV,
                              &buf, &p, NULL /* ppkd */ , content, contlen);
         ccnl_fwd_handleContent(relay, from, c);
@@ -485,6 +479,7 @@ ccnl_ndntlv_forwarder(struct ccnl_relay_s *relay, struct ccnl_face_s *from,
 {
     int len, rc=-1, typ;
     int mbf=0, minsfx=0, maxsfx=CCNL_MAX_NAME_COMP, scope=3, contlen;
+    int lifetime=0, freshness=-1;
     struct ccnl_buf_s *buf = 0, *nonce=0, *ppkl=0;
     struct ccnl_interest_s *i = 0;
     struct ccnl_content_s *c = 0;
@@ -496,12 +491,15 @@ ccnl_ndntlv_forwarder(struct ccnl_relay_s *relay, struct ccnl_face_s *from,
         return -1;
     buf = ccnl_ndntlv_extract(*data - cp,
                               data, datalen,
-                              &scope, &mbf, &minsfx, &maxsfx, 0, 
+                              &scope, &mbf, &minsfx, &maxsfx,
+                              &lifetime, &freshness, 0,
                               &p, &tracing, &nonce, &ppkl, &content, &contlen);
     if (!buf) {
         DEBUGMSG(DEBUG, "  parsing error or no prefix\n");
         goto Done;
     }
+    if (ccnl_worker_steer(relay, from, CCNL_SUITE_NDNTLV, p, buf))
+        goto Skip;
 
     if (typ == NDN_TLV_Interest) {
         if (nonce && ccnl_nonce_find_or_append(relay, nonce)) {
@@ -515,19 +513,18 @@ ccnl_ndntlv_forwarder(struct ccnl_relay_s *relay, struct ccnl_face_s *from,
             rc = ccnl_mgmt(relay, buf, p, from); goto Done;
         }
     */
-        // CONFORM: Step 1: search for matching local content
-        for (c = relay->contents; c; c = c->next) {
-            if (c->suite != CCNL_SUITE_NDNTLV) continue;
-            if (!ccnl_i_prefixof_c(p, minsfx, maxsfx, c)) continue;
-            if (ppkl && !buf_equal(ppkl, c->details.ndntlv.ppkl)) continue;
-            // FIXME: should check freshness (mbf) here
-            // if (mbf) // honor "answer-from-existing-content-store" flag
+        // CONFORM: Step 1: search for matching local content,
+        // stale content only if the interest does not ask for fresh data
+        c = ccnl_cstrie_lookup(relay, CCNL_SUITE_NDNTLV, p,
+                               minsfx, maxsfx, mbf, ppkl);
+        if (c) {
             DEBUGMSG(DEBUG, "  matching content for interest, content %p\n",
                      (void *) c);
+            ccnl_content_used(relay, c);
             if (from->ifndx >= 0) {
                 ccnl_nfn_monitor(relay, from, c->name, c->content,
                                  c->contentlen);
-                ccnl_face_enqueue(relay, from, buf_dup(c->pkt));
+                ccnl_face_enqueue(relay, from, ccnl_buf_ref(c->pkt));
             } else {
                 ccnl_app_RX(relay, c);
             }
@@ -540,11 +537,11 @@ ccnl_ndntlv_forwarder(struct ccnl_relay_s *relay, struct ccnl_face_s *from,
             }
         }
 #endif
-        for (i = relay->pit; i; i = i->next) {
-            if (i->suite == CCNL_SUITE_NDNTLV &&
-                !ccnl_prefix_cmp(i->prefix, NULL, p, CMP_EXACT) &&
-                i->details.ndntlv.minsuffix == minsfx &&
+        for (i = ccnl_pit_find(relay, NULL, CCNL_SUITE_NDNTLV, p); i;
+                           i = ccnl_pit_find(relay, i, CCNL_SUITE_NDNTLV, p)) {
+            if (i->details.ndntlv.minsuffix == minsfx &&
                 i->details.ndntlv.maxsuffix == maxsfx &&
+                i->details.ndntlv.mbf == mbf &&
                 ((!ppkl && !i->details.ndntlv.ppkl) ||
                  buf_equal(ppkl, i->details.ndntlv.ppkl)) )
                 break;
@@ -563,21 +560,24 @@ ccnl_ndntlv_forwarder(struct ccnl_relay_s *relay, struct ccnl_face_s *from,
         if (!i) {
             i = ccnl_interest_new(relay, from, CCNL_SUITE_NDNTLV,
                       &buf, &p, minsfx, maxsfx);
-            if (ppkl)
-                i->details.ndntlv.ppkl = ppkl, ppkl = NULL;
             if (i) { // CONFORM: Step 3 (and 4)
+                i->details.ndntlv.mbf = mbf;
+                i->details.ndntlv.ppkl = ppkl, ppkl = NULL;
+                ccnl_interest_setlifetime(relay, i, lifetime);
                 DEBUGMSG(DEBUG,
                          "  created new interest entry %p\n", (void *) i);
-                if (scope > 2)
-                    ccnl_interest_propagate(relay, i);
+                if (scope > 2 && ccnl_interest_propagate(relay, i))
+                    i = NULL;
             }
         } else if (scope > 2 && (from->flags & CCNL_FACE_FLAGS_FWDALLI)) {
             DEBUGMSG(DEBUG, "  old interest, nevertheless propagated %p\n",
                      (void *) i);
-            ccnl_interest_propagate(relay, i);
+            if (ccnl_interest_propagate(relay, i))
+                i = NULL;
         }
         if (i) { // store the I request, for the incoming face (Step 3)
             DEBUGMSG(DEBUG, "  appending interest entry %p\n", (void *) i);
+            ccnl_interest_extendlifetime(i, lifetime);
             ccnl_interest_append_pending(i, from);
         }
     } else { // data packet with content -------------------------------------
@@ -594,11 +594,20 @@ ccnl_ndntlv_forwarder(struct ccnl_relay_s *relay, struct ccnl_face_s *from,
 */
 
         // CONFORM: Step 1:
-        for (c = relay->contents; c; c = c->next)
-            if (buf_equal(c->pkt, buf))
-                goto Skip; // content is dup
+        c = ccnl_cs_findpkt(relay, CCNL_SUITE_NDNTLV, p, buf);
+        if (c) { // content is dup
+            if (c->flags & CCNL_CONTENT_FLAGS_STALE) {
+                // a fresh copy of stale content, for MustBeFresh
+                // interests that could not be answered from the cache
+                ccnl_content_refresh(relay, c);
+                ccnl_content_serve_pending(relay, c);
+            }
+            goto Skip;
+        }
         c = ccnl_content_new(relay, CCNL_SUITE_NDNTLV,
                              &buf, &p, NULL /* ppkd */ , content, contlen);
+        if (c)
+            c->freshness = freshness;
         ccnl_fwd_handleContent(relay, from, c);
     }
 
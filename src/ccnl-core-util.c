@@ -41,6 +41,9 @@ compile_string(void)
 #ifdef USE_DEBUG_MALLOC
         "DEBUG_MALLOC, "
 #endif
+#ifdef USE_EPOLL
+        "EPOLL, "
+#endif
 #ifdef USE_ETHERNET
         "ETHERNET, "
 #endif
@@ -50,12 +53,18 @@ compile_string(void)
 #ifdef USE_HTTP_STATUS
         "HTTP_STATUS, "
 #endif
+#ifdef USE_IOBATCH
+        "IOBATCH, "
+#endif
 #ifdef USE_KITE
         "KITE, "
 #endif
 #ifdef USE_LOGGING
         "LOGGING, "
 #endif
+#ifdef USE_MEMPOOL
+        "MEMPOOL, "
+#endif
 #ifdef USE_MGMT
         "MGMT, "
 #endif
@@ -94,6 +103,9 @@ compile_string(void)
 #endif
 #ifdef USE_UNIXSOCKET
         "UNIXSOCKET, "
+#endif
+#ifdef USE_WORKERS
+        "WORKERS, "
 #endif
         ;
   return cp;
@@ -159,25 +171,134 @@ ccnl_suite2str(int suite)
     return "?";
 }
 
+// ----------------------------------------------------------------------
+// hashing (FNV-1a)
+
+// continues hash h over a byte string
+unsigned int
+ccnl_hash_bytes(unsigned int h, unsigned char *data, int len)
+{
+    while (len-- > 0) {
+        h ^= *data++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// extends a cumulative name hash with the next name component
+unsigned int
+ccnl_hash_comp(unsigned int h, unsigned char *comp, int len)
+{
+    return ccnl_hash_bytes((h ^ len) * 16777619u, comp, len);
+}
+
+// hash over the first n components of a name (independent of the suite).
+// Compact prefixes remember these cumulative hashes in comphash[], so
+// that each one is computed only once per name: code which changes a
+// component (not just compcnt) of such a prefix must reset hashcnt.
+unsigned int
+ccnl_prefix_comphash(struct ccnl_prefix_s *p, int n)
+{
+    unsigned int h = ccnl_hash_init(0);
+    int i;
+
+    if (n > p->compcnt)
+        n = p->compcnt;
+    if (n <= 0)
+        return h;
+    if (!p->comphash) {
+        for (i = 0; i < n; i++)
+            h = ccnl_hash_comp(h, p->comp[i], p->complen[i]);
+        return h;
+    }
+    for (i = p->hashcnt; i < n; i++)
+        p->comphash[i] = ccnl_hash_comp(i ? p->comphash[i-1] : h,
+                                        p->comp[i], p->complen[i]);
+    if (p->hashcnt < n)
+        p->hashcnt = n;
+    return p->comphash[n-1];
+}
+
+// hash over the suite and the first n components of a name: names which
+// are equal for ccnl_prefix_cmp(..., CMP_EXACT) have the same hash
+unsigned int
+ccnl_prefix_hash(int suite, struct ccnl_prefix_s *p, int n)
+{
+    return (ccnl_prefix_comphash(p, n) ^ (unsigned char) suite) * 16777619u;
+}
+
+// the same for the name p, followed by the implicit digest component md
+unsigned int
+ccnl_prefix_hash_md(int suite, struct ccnl_prefix_s *p, unsigned char *md)
+{
+    unsigned int h = ccnl_hash_comp(ccnl_prefix_comphash(p, p->compcnt),
+                                    md, 32); // SHA256_DIGEST_LEN
+
+    return (h ^ (unsigned char) suite) * 16777619u;
+}
+
 // ----------------------------------------------------------------------
 
+// A prefix is a single allocation: the struct, followed by the comp[],
+// complen[] and comphash[] arrays for cnt components and by len bytes
+// for copies of the components (p->bytes, NULL if len is 0: the
+// components are elsewhere, e.g. in the packet they were parsed from).
+// Prefixes built by hand (compact not set) own separately allocated
+// arrays and bytes instead, see free_prefix().
 struct ccnl_prefix_s*
-ccnl_prefix_new(int suite, int cnt)
+ccnl_prefix_alloc(int suite, int cnt, int len)
 {
     struct ccnl_prefix_s *p;
 
-    p = (struct ccnl_prefix_s *) ccnl_calloc(1, sizeof(struct ccnl_prefix_s));
+    p = (struct ccnl_prefix_s *) ccnl_calloc_type(CCNL_MEMPOOL_PREFIX,
+                       sizeof(struct ccnl_prefix_s) + cnt *
+                       (sizeof(unsigned char*) + sizeof(int) +
+                        sizeof(unsigned int)) + len);
     if (!p)
         return NULL;
-    p->comp = (unsigned char**) ccnl_malloc(cnt * sizeof(unsigned char*));
-    p->complen = (int*) ccnl_malloc(cnt * sizeof(int));
-    if (!p->comp || !p->complen) {
-        free_prefix(p);
-        return NULL;
-    }
+    p->comp = (unsigned char**) (p + 1);
+    p->complen = (int*) (p->comp + cnt);
+    p->comphash = (unsigned int*) (p->complen + cnt);
+    if (len > 0)
+        p->bytes = (unsigned char*) (p->comphash + cnt);
     p->compcnt = cnt;
     p->suite = suite;
-    p->chunknum = NULL;
+    p->compact = 1;
+
+    return p;
+}
+
+struct ccnl_prefix_s*
+ccnl_prefix_new(int suite, int cnt)
+{
+    return ccnl_prefix_alloc(suite, cnt, 0);
+}
+
+// turns a prefix which was collected on the stack while parsing a
+// packet into a compact one, sized to its component count; the
+// components stay where they are, their hashes are taken over
+struct ccnl_prefix_s*
+ccnl_prefix_pack(struct ccnl_prefix_s *tmp)
+{
+    struct ccnl_prefix_s *p = ccnl_prefix_new(tmp->suite, tmp->compcnt);
+
+    if (!p) {
+        ccnl_free(tmp->chunknum);
+        return NULL;
+    }
+    memcpy(p->comp, tmp->comp, tmp->compcnt * sizeof(unsigned char*));
+    memcpy(p->complen, tmp->complen, tmp->compcnt * sizeof(int));
+    if (tmp->comphash) { // computed while parsing
+        p->hashcnt = tmp->hashcnt < tmp->compcnt ? tmp->hashcnt : tmp->compcnt;
+        memcpy(p->comphash, tmp->comphash, p->hashcnt * sizeof(unsigned int));
+    }
+    p->nameptr = tmp->nameptr;
+    p->namelen = tmp->namelen;
+    p->chunknum = tmp->chunknum;
+#ifdef USE_NFN
+    p->nfnflags = tmp->nfnflags;
+#endif
+    ccnl_prefix_comphash(p, p->compcnt);
 
     return p;
 }
@@ -307,10 +428,6 @@ ccnl_componentsToPrefix(char** compvect, unsigned int *complens, int numcomps,
     if (nfnexpr && *nfnexpr)
     cnt += 1;
     
-    p = ccnl_prefix_new(suite, cnt);
-    if (!p)
-    return NULL;
-    
     for (i = 0, len = 0; i < cnt; i++) {
         if (i == (cnt-1) && nfnexpr && *nfnexpr)
         len += strlen(nfnexpr);
@@ -322,11 +439,9 @@ ccnl_componentsToPrefix(char** compvect, unsigned int *complens, int numcomps,
     len += cnt * 4; // add TL size
 #endif
     
-    p->bytes = ccnl_malloc(len);
-    if (!p->bytes) {
-        free_prefix(p);
-        return NULL;
-    }
+    p = ccnl_prefix_alloc(suite, cnt, len);
+    if (!p)
+    return NULL;
     
     for (i = 0, len = 0, tlen = 0; i < cnt; i++) {
         int isnfnfcomp = i == (cnt-1) && nfnexpr && *nfnexpr;
@@ -353,6 +468,7 @@ ccnl_componentsToPrefix(char** compvect, unsigned int *complens, int numcomps,
         p->chunknum = ccnl_malloc(sizeof(int));
         *p->chunknum = *chunknum;
     }
+    ccnl_prefix_comphash(p, cnt);
     
     return p;
     
@@ -384,30 +500,22 @@ ccnl_prefix_dup(struct ccnl_prefix_s *prefix)
     int i = 0, len;
     struct ccnl_prefix_s *p;
 
-    p = ccnl_prefix_new(prefix->suite, prefix->compcnt);
+    for (i = 0, len = 0; i < prefix->compcnt; i++)
+        len += prefix->complen[i];
+    p = ccnl_prefix_alloc(prefix->suite, prefix->compcnt, len);
     if (!p)
         return p;
 
-    p->compcnt = prefix->compcnt;
-    p->chunknum = prefix->chunknum;
 #ifdef USE_NFN
     p->nfnflags = prefix->nfnflags;
 #endif
-
-    for (i = 0, len = 0; i < prefix->compcnt; i++)
-        len += prefix->complen[i];
-    p->bytes = ccnl_malloc(len);
-    if (!p->bytes) {
-        free_prefix(p);
-        return NULL;
-    }
-    
     for (i = 0, len = 0; i < prefix->compcnt; i++) {
         p->complen[i] = prefix->complen[i];
         p->comp[i] = p->bytes + len;
         memcpy(p->bytes + len, prefix->comp[i], p->complen[i]);
         len += p->complen[i];
     }
+    ccnl_prefix_comphash(p, p->compcnt);
 
     if (prefix->chunknum) {
         p->chunknum = ccnl_malloc(sizeof(int));
@@ -435,26 +543,30 @@ ccnl_prefix_appendCmp(struct ccnl_prefix_s *prefix, unsigned char *cmp,
         prefixlen += prefix->complen[i];
     }
 
+    // the struct must stay where it is: a compact prefix (with its
+    // arrays right after the struct) becomes one with separate arrays
     prefix->compcnt++;
     prefix->comp = (unsigned char**) ccnl_malloc(prefix->compcnt * sizeof(unsigned char*));
     prefix->complen = (int*) ccnl_malloc(prefix->compcnt * sizeof(int));
     prefix->bytes = (unsigned char*) ccnl_malloc(prefixlen + cmplen);
 
-    memcpy(prefix->bytes, oldbytes, prefixlen);
-    memcpy(prefix->bytes + prefixlen, cmp, cmplen);
-
     prefixlen = 0;
     for (i = 0; i < lastcmp; i++) {
         prefix->comp[i] = &prefix->bytes[prefixlen];
         prefix->complen[i] = oldcomplen[i];
+        memcpy(prefix->comp[i], oldcomp[i], oldcomplen[i]);
         prefixlen += oldcomplen[i];
     }
     prefix->comp[lastcmp] = &prefix->bytes[prefixlen];
     prefix->complen[lastcmp] = cmplen;
+    memcpy(prefix->comp[lastcmp], cmp, cmplen);
+    prefix->comphash = NULL;
+    prefix->hashcnt = 0;
 
-    ccnl_free(oldcomp);
-    ccnl_free(oldcomplen);
-    ccnl_free(oldbytes);
+    if (prefix->compact)
+        prefix->compact = 0;
+    else
+        free_3ptr_list(oldbytes, oldcomp, oldcomplen);
 
     return 0;
 }
@@ -577,7 +689,7 @@ ccnl_pkt2suite(unsigned char *data, int len, int *skip)
 char*
 ccnl_addr2ascii(sockunion *su)
 {
-    static char result[130];
+    static CCNL_THREADLOCAL char result[130];
 
     switch (su->sa.sa_family) {
 #ifdef USE_ETHERNET
@@ -605,36 +717,49 @@ ccnl_addr2ascii(sockunion *su)
     return NULL;
 }
 
+#ifdef USE_IOBATCH
+// renders a batch size histogram as "1:n 2-3:n 4-7:n ..."
+char*
+ccnl_iohist2ascii(unsigned long *hist)
+{
+    static CCNL_THREADLOCAL char result[CCNL_IO_HISTLEN * 32];
+    int i, len = 0;
+
+    result[0] = '\0';
+    for (i = 0; i < CCNL_IO_HISTLEN; i++) {
+        if (!hist[i])
+            continue;
+        if (i == 0)
+            len += sprintf(result + len, "%s1:%lu", len ? " " : "", hist[i]);
+        else
+            len += sprintf(result + len, "%s%d-%d:%lu", len ? " " : "",
+                           1 << i, (1 << (i+1)) - 1, hist[i]);
+    }
+    return result;
+}
+#endif
+
 // ----------------------------------------------------------------------
 
 #ifndef CCNL_LINUXKERNEL
 
-static char *prefix_buf1;
-static char *prefix_buf2;
-static char *buf;
+// the result alternates between two buffers (two names can be printed by
+// the same statement), each thread has its own pair
+static CCNL_THREADLOCAL char prefix_buf[2][2048];
+static CCNL_THREADLOCAL int prefix_bufidx;
 
 char*
 ccnl_prefix_to_path_detailed(struct ccnl_prefix_s *pr, int ccntlv_skip,
                              int escape_components, int call_slash)
 {
     int len = 0, i, j;
+    char *buf;
 
     if (!pr)
         return NULL;
 
-    if (!buf) {
-        struct ccnl_buf_s *b;
-        b = ccnl_buf_new(NULL, 2048);
-        ccnl_core_addToCleanup(b);
-        prefix_buf1 = (char*) b->data;
-        b = ccnl_buf_new(NULL, 2048);
-        ccnl_core_addToCleanup(b);
-        prefix_buf2 = (char*) b->data;
-        buf = prefix_buf1;
-    } else if (buf == prefix_buf2)
-        buf = prefix_buf1;
-    else
-        buf = prefix_buf2;
+    prefix_bufidx ^= 1;
+    buf = prefix_buf[prefix_bufidx];
 
 #ifdef USE_NFN
     if (pr->nfnflags & CCNL_PREFIX_NFN)
@@ -27,7 +27,22 @@
 #endif
 
 // forward reference:
+struct ccnl_buf_s* ccnl_face_dequeue(struct ccnl_relay_s *ccnl,
+                                     struct ccnl_face_s *f);
 void ccnl_face_CTS(struct ccnl_relay_s *ccnl, struct ccnl_face_s *f);
+static void ccnl_interface_unwait(struct ccnl_relay_s *ccnl,
+                                  struct ccnl_face_s *f);
+void ccnl_face_ageing(void *relay, void *aux);
+void ccnl_interest_ageing(void *relay, void *aux);
+void ccnl_content_ageing(void *relay, void *aux);
+int ccnl_i_prefixof_c(struct ccnl_prefix_s *prefix,
+                      int minsuffix, int maxsuffix, struct ccnl_content_s *c);
+unsigned char* ccnl_content_digest(struct ccnl_content_s *c);
+unsigned int ccnl_hash_bytes(unsigned int h, unsigned char *data, int len);
+unsigned int ccnl_prefix_comphash(struct ccnl_prefix_s *p, int n);
+unsigned int ccnl_prefix_hash(int suite, struct ccnl_prefix_s *p, int n);
+unsigned int ccnl_prefix_hash_md(int suite, struct ccnl_prefix_s *p,
+                                 unsigned char *md);
 
 // ----------------------------------------------------------------------
 // datastructure support functions
@@ -36,7 +51,29 @@ void ccnl_face_CTS(struct ccnl_relay_s *ccnl, struct ccnl_face_s *f);
 #define buf_equal(X,Y)  ((X) && (Y) && (X->datalen==Y->datalen) &&\
                          !memcmp(X->data,Y->data,X->datalen))
 
+// the fingerprint of a packet, computed on first use: from then on,
+// the buf must not change
+unsigned int
+ccnl_buf_fp(struct ccnl_buf_s *buf)
+{
+    if (!buf->fp) {
+        buf->fp = ccnl_hash_bytes(ccnl_hash_init(0), buf->data, buf->datalen);
+        if (!buf->fp)
+            buf->fp = 1;
+    }
+    return buf->fp;
+}
+
+// buf_equal(), but looking at the fingerprints first
+static int
+ccnl_buf_same(struct ccnl_buf_s *a, struct ccnl_buf_s *b)
+{
+    return a == b || (ccnl_buf_fp(a) == ccnl_buf_fp(b) && buf_equal(a, b));
+}
+
+struct ccnl_prefix_s* ccnl_prefix_alloc(int suite, int cnt, int len);
 struct ccnl_prefix_s* ccnl_prefix_new(int suite, int cnt);
+struct ccnl_prefix_s* ccnl_prefix_pack(struct ccnl_prefix_s *tmp);
 
 int
 ccnl_prefix_cmp(struct ccnl_prefix_s *name, unsigned char *md,
@@ -45,9 +82,14 @@ ccnl_prefix_cmp(struct ccnl_prefix_s *name, unsigned char *md,
    returns  0 if full match (CMP_EXACT)
    returns n>0 for matched components (CMP_MATCH, CMP_LONGEST) */
 {
-    int i, clen, nlen = name->compcnt + (md ? 1 : 0), rc = -1;
+    int i, clen, nlen = name->compcnt + (md ? 1 : 0), rc = -1, hcnt = 0;
     unsigned char *comp;
 
+    if (name->comphash && p->comphash) { // cumulative hashes known for both
+        hcnt = name->hashcnt < p->hashcnt ? name->hashcnt : p->hashcnt;
+        if (hcnt > name->compcnt)
+            hcnt = name->compcnt;
+    }
     if (mode == CMP_EXACT) {
         if (nlen != p->compcnt)
             goto done;
@@ -55,11 +97,15 @@ ccnl_prefix_cmp(struct ccnl_prefix_s *name, unsigned char *md,
         if (p->nfnflags != name->nfnflags)
             goto done;
 #endif
+        if (hcnt > 0 && hcnt == nlen &&
+                        name->comphash[hcnt-1] != p->comphash[hcnt-1])
+            goto done;
     }
     for (i = 0; i < nlen && i < p->compcnt; ++i) {
         comp = i < name->compcnt ? name->comp[i] : md;
         clen = i < name->compcnt ? name->complen[i] : 32; // SHA256_DIGEST_LEN
-        if (clen != p->complen[i] || memcmp(comp, p->comp[i], p->complen[i])) {
+        if ((i < hcnt && name->comphash[i] != p->comphash[i]) ||
+              clen != p->complen[i] || memcmp(comp, p->comp[i], p->complen[i])) {
             rc = mode == CMP_EXACT ? -1 : i;
             goto done;
         }
@@ -72,6 +118,106 @@ done:
     return rc;
 }
 
+// ----------------------------------------------------------------------
+// hash tables (chained, intrusive) for indexing the relay's tables
+
+// (the hash functions, also for names, are in ccnl-core-util.c)
+
+static int
+ccnl_hashtab_resize(struct ccnl_hashtab_s *t, unsigned int size)
+{
+    struct ccnl_hashlink_s **b, *l;
+    unsigned int i;
+
+    b = (struct ccnl_hashlink_s**) ccnl_calloc(size, sizeof(*b));
+    if (!b)
+        return -1;
+    for (i = 0; i < t->size; i++) {
+        while ((l = t->bucket[i])) {
+            t->bucket[i] = l->next;
+            l->next = b[l->hash & (size - 1)];
+            b[l->hash & (size - 1)] = l;
+        }
+    }
+    ccnl_free(t->bucket);
+    t->bucket = b;
+    t->size = size;
+    return 0;
+}
+
+void
+ccnl_hashtab_add(struct ccnl_hashtab_s *t, struct ccnl_hashlink_s *l,
+                 unsigned int hash, void *obj)
+{
+    struct ccnl_hashlink_s **b;
+
+    if (t->cnt >= t->size &&
+        ccnl_hashtab_resize(t, t->size ? 2*t->size : CCNL_HASHTAB_MINSIZE) &&
+        !t->size) {
+        DEBUGMSG(ERROR, "ccnl_hashtab_add: no memory, object not indexed\n");
+        l->obj = NULL;
+        return;
+    }
+    b = t->bucket + (hash & (t->size - 1));
+    l->hash = hash;
+    l->obj = obj;
+    l->next = *b;
+    *b = l;
+    t->cnt++;
+}
+
+void
+ccnl_hashtab_remove(struct ccnl_hashtab_s *t, struct ccnl_hashlink_s *l)
+{
+    struct ccnl_hashlink_s **pp;
+
+    if (!l->obj)
+        return;
+    for (pp = t->bucket + (l->hash & (t->size - 1)); *pp; pp = &(*pp)->next)
+        if (*pp == l) {
+            *pp = l->next;
+            t->cnt--;
+            break;
+        }
+    l->next = NULL;
+    l->obj = NULL;
+}
+
+// returns the next link (after l) in the same bucket with the same hash
+struct ccnl_hashlink_s*
+ccnl_hashtab_next(struct ccnl_hashlink_s *l)
+{
+    unsigned int hash = l->hash;
+
+    for (l = l->next; l; l = l->next)
+        if (l->hash == hash)
+            return l;
+    return NULL;
+}
+
+// returns the first link with the given hash, use ccnl_hashtab_next()
+// to iterate over the others (the caller has to resolve collisions)
+struct ccnl_hashlink_s*
+ccnl_hashtab_first(struct ccnl_hashtab_s *t, unsigned int hash)
+{
+    struct ccnl_hashlink_s *l;
+
+    if (!t->size)
+        return NULL;
+    for (l = t->bucket[hash & (t->size - 1)]; l; l = l->next)
+        if (l->hash == hash)
+            return l;
+    return NULL;
+}
+
+void
+ccnl_hashtab_cleanup(struct ccnl_hashtab_s *t)
+{
+    ccnl_free(t->bucket);
+    t->bucket = NULL;
+    t->size = t->cnt = 0;
+}
+
 // ----------------------------------------------------------------------
 // addresses, interfaces and faces
 
@@ -98,6 +244,33 @@ ccnl_addr_cmp(sockunion *s1, sockunion *s2)
     return -1;
 }
 
+// hash over the parts of an address that ccnl_addr_cmp() looks at
+unsigned int
+ccnl_addr_hash(sockunion *su)
+{
+    unsigned int h = ccnl_hash_init(su->sa.sa_family);
+
+    switch (su->sa.sa_family) {
+#ifdef USE_ETHERNET
+        case AF_PACKET:
+            return ccnl_hash_bytes(h, su->eth.sll_addr, ETH_ALEN);
+#endif
+        case AF_INET:
+            h = ccnl_hash_bytes(h, (unsigned char*) &su->ip4.sin_addr.s_addr,
+                                sizeof(su->ip4.sin_addr.s_addr));
+            return ccnl_hash_bytes(h, (unsigned char*) &su->ip4.sin_port,
+                                   sizeof(su->ip4.sin_port));
+#ifdef USE_UNIXSOCKET
+        case AF_UNIX:
+            return ccnl_hash_bytes(h, (unsigned char*) su->ux.sun_path,
+                                   strlen(su->ux.sun_path));
+#endif
+        default:
+            break;
+    }
+    return h;
+}
+
 struct ccnl_face_s*
 ccnl_get_face_or_create(struct ccnl_relay_s *ccnl, int ifndx,
                        struct sockaddr *sa, int addrlen)
@@ -105,20 +278,24 @@ ccnl_get_face_or_create(struct ccnl_relay_s *ccnl, int ifndx,
 // sa!=NULL && ifndx==-1: search suitable interface for given sa_family
 // sa!=NULL && ifndx!=-1: use this (incoming) interface for outgoing
 {
-    static int seqno, i;
     struct ccnl_face_s *f;
+    struct ccnl_hashlink_s *l;
+    int i;
     DEBUGMSG(TRACE, "ccnl_get_face_or_create src=%s\n",
              sa ? ccnl_addr2ascii((sockunion*)sa) : "(local)");
 
-    for (f = ccnl->faces; f; f = f->next) {
-        if (!sa) {
+    if (!sa) {
+        for (f = ccnl->faces; f; f = f->next)
             if (f->ifndx == -1)
                 return f;
-            continue;
-        }
-        if (ifndx != -1 && !ccnl_addr_cmp(&f->peer, (sockunion*)sa)) {
-            f->last_used = CCNL_NOW();
-            return f;
+    } else if (ifndx != -1) {
+        l = ccnl_hashtab_first(&ccnl->faceidx, ccnl_addr_hash((sockunion*)sa));
+        for (; l; l = ccnl_hashtab_next(l)) {
+            f = (struct ccnl_face_s*) l->obj;
+            if (!ccnl_addr_cmp(&f->peer, (sockunion*)sa)) {
+                f->last_used = CCNL_NOW();
+                return f;
+            }
         }
     }
 
@@ -135,10 +312,11 @@ ccnl_get_face_or_create(struct ccnl_relay_s *ccnl, int ifndx,
     DEBUGMSG(VERBOSE, "  found suitable interface %d for %s\n", ifndx,
              sa ? ccnl_addr2ascii((sockunion*)sa) : "(local)");
 
-    f = (struct ccnl_face_s *) ccnl_calloc(1, sizeof(struct ccnl_face_s));
+    f = (struct ccnl_face_s *) ccnl_calloc_type(CCNL_MEMPOOL_FACE,
+                                                sizeof(struct ccnl_face_s));
     if (!f)
         return NULL;
-    f->faceid = ++seqno;
+    f->faceid = ++ccnl->lastfaceid;
     f->ifndx = ifndx;
 
     if (ifndx >= 0) {
@@ -149,11 +327,15 @@ ccnl_get_face_or_create(struct ccnl_relay_s *ccnl, int ifndx,
         if (ccnl->ifs[ifndx].fwdalli)   f->flags |= CCNL_FACE_FLAGS_FWDALLI;
     }
 
-    if (sa)
+    if (sa) {
         memcpy(&f->peer, sa, addrlen);
-    else // local client
+        ccnl_hashtab_add(&ccnl->faceidx, &f->facelink,
+                         ccnl_addr_hash(&f->peer), f);
+    } else // local client
         f->ifndx = -1;
     f->last_used = CCNL_NOW();
+    f->timer = ccnl_set_timer(CCNL_FACE_TIMEOUT * 1000000,
+                              ccnl_face_ageing, ccnl, f);
     DBL_LINKED_LIST_ADD(ccnl->faces, f);
     return f;
 }
@@ -164,6 +346,8 @@ ccnl_face_remove(struct ccnl_relay_s *ccnl, struct ccnl_face_s *f)
     struct ccnl_face_s *f2;
     struct ccnl_interest_s *pit;
     struct ccnl_forward_s **ppfwd;
+    struct ccnl_buf_s *buf;
+    int j, k;
 
     DEBUGMSG(DEBUG, "face_remove relay=%p face=%p\n",
              (void*)ccnl, (void*)f);
@@ -191,19 +375,36 @@ ccnl_face_remove(struct ccnl_relay_s *ccnl, struct ccnl_face_s *f)
     for (ppfwd = &ccnl->fib; *ppfwd;) {
         if ((*ppfwd)->face == f) {
             struct ccnl_forward_s *pfwd = *ppfwd;
+            ccnl_hashtab_remove(&ccnl->fibidx, &pfwd->fiblink);
             free_prefix(pfwd->prefix);
             *ppfwd = pfwd->next;
             ccnl_free(pfwd);
+            ccnl->fibgen++;
         } else
             ppfwd = &(*ppfwd)->next;
     }
-    while (f->outq) {
-        struct ccnl_buf_s *tmp = f->outq->next;
-        ccnl_free(f->outq);
-        f->outq = tmp;
+    while ((buf = ccnl_face_dequeue(ccnl, f)))
+        ccnl_buf_release(buf);
+    ccnl_free(f->outq);
+    ccnl_free(f->outqset);
+    ccnl_interface_unwait(ccnl, f);
+    // packets already handed to an interface are sent without the face
+    for (k = 0; f->ifqcnt > 0 && k < ccnl->ifcount; k++) {
+        struct ccnl_if_s *ifc = ccnl->ifs + k;
+        for (j = 0; f->ifqcnt > 0 && j < ifc->qlen; j++) {
+            struct ccnl_txrequest_s *r = ifc->queue +
+                                         (ifc->qfront + j) % ifc->qmax;
+            if (r->txdone_face == f) {
+                r->txdone = NULL;
+                r->txdone_face = NULL;
+                f->ifqcnt--;
+            }
+        }
     }
+    ccnl_rem_timer(f->timer);
     f2 = f->next;
     DBL_LINKED_LIST_REMOVE(ccnl->faces, f);
+    ccnl_hashtab_remove(&ccnl->faceidx, &f->facelink);
     ccnl_free(f);
     return f2;
 }
@@ -216,21 +417,126 @@ ccnl_interface_cleanup(struct ccnl_if_s *i)
 
     ccnl_sched_destroy(i->sched);
     for (j = 0; j < i->qlen; j++) {
-        struct ccnl_txrequest_s *r = i->queue + (i->qfront+j)%CCNL_MAX_IF_QLEN;
-        ccnl_free(r->buf);
+        struct ccnl_txrequest_s *r = i->queue + (i->qfront + j) % i->qmax;
+        ccnl_buf_release(r->buf);
     }
+    ccnl_free(i->queue);
+    i->queue = NULL;
     ccnl_close_socket(i->sock);
 }
 
 // ----------------------------------------------------------------------
 // face and interface queues, scheduling
 
+// An interface has a ring of qmax pending sends. A face only hands over
+// a packet when the ring has room: otherwise the packet stays in the
+// face's own queue (of at most CCNL_MAX_FACE_QLEN packets), the face is
+// marked as waiting, and is served when the interface sent something.
+// Without USE_SCHEDULER a packet is sent as soon as it is handed over,
+// unless the platform marked the interface as busy (txbusy): then the
+// packets stay in the ring until the IO loop sees the device take more.
+
+// sets the size of an interface's queue (0: default), keeps what is queued
+int
+ccnl_interface_setqlen(struct ccnl_if_s *ifc, int qmax)
+{
+    struct ccnl_txrequest_s *q;
+    int j;
+
+    if (qmax <= 0)
+        qmax = CCNL_MAX_IF_QLEN;
+    if (qmax < ifc->qlen)
+        return -1;
+    q = (struct ccnl_txrequest_s*) ccnl_malloc(qmax * sizeof(*q));
+    if (!q)
+        return -1;
+    for (j = 0; j < ifc->qlen; j++)
+        memcpy(q + j, ifc->queue + (ifc->qfront + j) % ifc->qmax, sizeof(*q));
+    ccnl_free(ifc->queue);
+    ifc->queue = q;
+    ifc->qfront = 0;
+    ifc->qmax = qmax;
+    return 0;
+}
+
+static int
+ccnl_interface_full(struct ccnl_if_s *ifc)
+{
+    return ifc->qlen >= (ifc->qmax ? ifc->qmax : CCNL_MAX_IF_QLEN);
+}
+
+// a face waiting for room in its interface's ring is appended to the
+// interface's list of waiting faces, which are then served in turn
+static void
+ccnl_interface_wait(struct ccnl_relay_s *ccnl, struct ccnl_face_s *f)
+{
+    struct ccnl_if_s *ifc = ccnl->ifs + f->ifndx;
+
+    if (f->flags & CCNL_FACE_FLAGS_IFWAIT)
+        return;
+    f->flags |= CCNL_FACE_FLAGS_IFWAIT;
+    f->qwaitnext = NULL;
+    f->qwaitprev = ifc->qwaittail;
+    if (ifc->qwaittail)
+        ifc->qwaittail->qwaitnext = f;
+    else
+        ifc->qwaithead = f;
+    ifc->qwaittail = f;
+    ifc->qwait++;
+}
+
+static void
+ccnl_interface_unwait(struct ccnl_relay_s *ccnl, struct ccnl_face_s *f)
+{
+    struct ccnl_if_s *ifc = ccnl->ifs + f->ifndx;
+
+    if (!(f->flags & CCNL_FACE_FLAGS_IFWAIT))
+        return;
+    f->flags &= ~CCNL_FACE_FLAGS_IFWAIT;
+    if (f->qwaitprev)
+        f->qwaitprev->qwaitnext = f->qwaitnext;
+    else
+        ifc->qwaithead = f->qwaitnext;
+    if (f->qwaitnext)
+        f->qwaitnext->qwaitprev = f->qwaitprev;
+    else
+        ifc->qwaittail = f->qwaitprev;
+    f->qwaitnext = f->qwaitprev = NULL;
+    ifc->qwait--;
+}
+
+// hands the packets held back by waiting faces to the interface, one
+// face after the other, as long as there is room
+static void
+ccnl_interface_pull(struct ccnl_relay_s *ccnl, struct ccnl_if_s *ifc)
+{
+    static CCNL_THREADLOCAL int pulling;
+    struct ccnl_face_s *f;
+    int outqlen;
+
+    if (pulling) // sending may free slots again, the loop below covers it
+        return;
+    pulling = 1;
+    while ((f = ifc->qwaithead) && !ccnl_interface_full(ifc)) {
+        ccnl_interface_unwait(ccnl, f);
+        outqlen = f->outqlen;
+        ccnl_face_CTS(ccnl, f);
+        // a face scheduler asks again by itself, otherwise the face
+        // keeps waiting (at the end of the line) while it makes progress
+        // and has packets left
+        if (!f->sched && f->outqlen > 0 && f->outqlen < outqlen)
+            ccnl_interface_wait(ccnl, f);
+    }
+    pulling = 0;
+}
+
 void
 ccnl_interface_CTS(void *aux1, void *aux2)
 {
     struct ccnl_relay_s *ccnl = (struct ccnl_relay_s *)aux1;
     struct ccnl_if_s *ifc = (struct ccnl_if_s *)aux2;
     struct ccnl_txrequest_s *r, req;
+    double sojourn;
 
     DEBUGMSG(TRACE, "interface_CTS interface=%p, qlen=%d, sched=%p\n",
              (void*)ifc, ifc->qlen, (void*)ifc->sched);
@@ -239,16 +545,25 @@ ccnl_interface_CTS(void *aux1, void *aux2)
         return;
     r = ifc->queue + ifc->qfront;
     memcpy(&req, r, sizeof(req));
-    ifc->qfront = (ifc->qfront + 1) % CCNL_MAX_IF_QLEN;
+    ifc->qfront = (ifc->qfront + 1) % ifc->qmax;
     ifc->qlen--;
 
+    sojourn = CCNL_NOW() - req.enqueued;
+    ifc->sojourn += sojourn;
+    if (sojourn > ifc->sojournmax)
+        ifc->sojournmax = sojourn;
+    ifc->txcnt++;
     ccnl_ll_TX(ccnl, ifc, &req.dst, req.buf);
 #ifdef USE_SCHEDULER
     ccnl_sched_CTS_done(ifc->sched, 1, req.buf->datalen);
     if (req.txdone)
         req.txdone(req.txdone_face, 1, req.buf->datalen);
 #endif
-    ccnl_free(req.buf);
+    if (req.txdone_face)
+        req.txdone_face->ifqcnt--;
+    ccnl_buf_release(req.buf);
+    if (ifc->qwait > 0)
+        ccnl_interface_pull(ccnl, ifc);
 }
 
 void
@@ -260,25 +575,101 @@ ccnl_interface_enqueue(void (tx_done)(void*, int, int), struct ccnl_face_s *f,
     DEBUGMSG(TRACE, "enqueue interface=%p buf=%p len=%d (qlen=%d)\n",
              (void*)ifc, (void*)buf, buf->datalen, ifc->qlen);
 
-    if (ifc->qlen >= CCNL_MAX_IF_QLEN) {
+    if (ccnl_interface_full(ifc) ||
+                    (!ifc->queue && ccnl_interface_setqlen(ifc, ifc->qmax))) {
         DEBUGMSG(WARNING, "  DROPPING buf=%p\n", (void*)buf);
-        ccnl_free(buf);
+        ifc->drops++;
+        ccnl_buf_release(buf);
         return;
     }
-    r = ifc->queue + ((ifc->qfront + ifc->qlen) % CCNL_MAX_IF_QLEN);
+    r = ifc->queue + ((ifc->qfront + ifc->qlen) % ifc->qmax);
     r->buf = buf;
     memcpy(&r->dst, dest, sizeof(sockunion));
     r->txdone = tx_done; 
     r->txdone_face = f; 
-    ifc->qlen++;
+    if (f)
+        f->ifqcnt++;
+    r->enqueued = CCNL_NOW();
+    if (++ifc->qlen > ifc->qpeak)
+        ifc->qpeak = ifc->qlen;
 
 #ifdef USE_SCHEDULER
     ccnl_sched_RTS(ifc->sched, 1, buf->datalen, ccnl, ifc);
 #else
-    ccnl_interface_CTS(ccnl, ifc);
+    if (!ifc->txbusy) // else the platform's IO loop drains the ring later
+        ccnl_interface_CTS(ccnl, ifc);
 #endif
 }
 
+// the face queue only holds references, so the same buf can wait on
+// several faces at once (fan-out to multiple PIT faces without a copy)
+
+// The queued bufs are also kept in a set, open addressing by fingerprint
+// with twice as many slots as the queue, so that checking for a
+// duplicate only looks at bufs with a similar fingerprint. Returns the
+// slot holding a buf like the given one, or the empty slot for it.
+static struct ccnl_buf_s**
+ccnl_face_fpfind(struct ccnl_face_s *f, struct ccnl_buf_s *buf)
+{
+    unsigned int mask = 2 * f->outqmax - 1, k;
+
+    for (k = ccnl_buf_fp(buf) & mask; f->outqset[k]; k = (k + 1) & mask)
+        if (ccnl_buf_same(f->outqset[k], buf))
+            break;
+    return f->outqset + k;
+}
+
+// removes a buf from the set, moving later entries of the same probe
+// sequence back into the hole
+static void
+ccnl_face_fpremove(struct ccnl_face_s *f, struct ccnl_buf_s *buf)
+{
+    unsigned int mask = 2 * f->outqmax - 1, i, j, home;
+    struct ccnl_buf_s **set = f->outqset;
+
+    i = ccnl_face_fpfind(f, buf) - set;
+    if (!set[i])
+        return;
+    for (j = (i + 1) & mask; set[j]; j = (j + 1) & mask) {
+        home = set[j]->fp & mask;
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            set[i] = set[j];
+            i = j;
+        }
+    }
+    set[i] = NULL;
+}
+
+static int
+ccnl_face_growqueue(struct ccnl_face_s *f)
+{
+    int max = f->outqmax ? 2 * f->outqmax : 4, j;
+    struct ccnl_buf_s **q, **set;
+
+    if (f->outqmax >= CCNL_MAX_FACE_QLEN)
+        return -1;
+    if (max > CCNL_MAX_FACE_QLEN)
+        max = CCNL_MAX_FACE_QLEN;
+    q = ccnl_malloc(max * sizeof(*q));
+    set = ccnl_calloc(2 * max, sizeof(*set));
+    if (!q || !set) {
+        ccnl_free(q);
+        ccnl_free(set);
+        return -1;
+    }
+    for (j = 0; j < f->outqlen; j++)
+        q[j] = f->outq[(f->outqfront + j) % f->outqmax];
+    ccnl_free(f->outq);
+    ccnl_free(f->outqset);
+    f->outq = q;
+    f->outqset = set;
+    f->outqfront = 0;
+    f->outqmax = max;
+    for (j = 0; j < f->outqlen; j++)
+        *ccnl_face_fpfind(f, q[j]) = q[j];
+    return 0;
+}
+
 struct ccnl_buf_s*
 ccnl_face_dequeue(struct ccnl_relay_s *ccnl, struct ccnl_face_s *f)
 {
@@ -286,13 +677,12 @@ ccnl_face_dequeue(struct ccnl_relay_s *ccnl, struct ccnl_face_s *f)
     DEBUGMSG(TRACE, "dequeue face=%p (id=%d.%d)\n",
              (void *) f, ccnl->id, f->faceid);
 
-    if (!f->outq)
+    if (f->outqlen <= 0)
         return NULL;
-    pkt = f->outq;
-    f->outq = pkt->next;
-    if (!pkt->next)
-        f->outqend = NULL;
-    pkt->next = NULL;
+    pkt = f->outq[f->outqfront];
+    f->outqfront = (f->outqfront + 1) % f->outqmax;
+    f->outqlen--;
+    ccnl_face_fpremove(f, pkt);
     return pkt;
 }
 
@@ -313,6 +703,11 @@ ccnl_face_CTS(struct ccnl_relay_s *ccnl, struct ccnl_face_s *f)
     struct ccnl_buf_s *buf;
     DEBUGMSG(TRACE, "CTS face=%p sched=%p\n", (void*)f, (void*)f->sched);
 
+    if (f->ifndx >= 0 && ccnl_interface_full(ccnl->ifs + f->ifndx)) {
+        // keep the packet here until ccnl_interface_pull() asks for it
+        ccnl_interface_wait(ccnl, f);
+        return;
+    }
     if (!f->frag || f->frag->protocol == CCNL_FRAG_NONE) {
         buf = ccnl_face_dequeue(ccnl, f);
         if (buf)
@@ -344,22 +739,25 @@ int
 ccnl_face_enqueue(struct ccnl_relay_s *ccnl, struct ccnl_face_s *to,
                  struct ccnl_buf_s *buf)
 {
-    struct ccnl_buf_s *msg;
     DEBUGMSG(TRACE, "enqueue face=%p (id=%d.%d) buf=%p len=%d\n",
              (void*) to, ccnl->id, to->faceid, (void*) buf, buf->datalen);
 
-    for (msg = to->outq; msg; msg = msg->next) // already in the queue?
-        if (buf_equal(msg, buf)) {
-            DEBUGMSG(VERBOSE, "    not enqueued because already there\n");
-            ccnl_free(buf);
-            return -1;
-        }
-    buf->next = NULL;
-    if (to->outqend)
-        to->outqend->next = buf;
-    else
-        to->outq = buf;
-    to->outqend = buf;
+    // already in the queue?
+    if (to->outqlen > 0 && *ccnl_face_fpfind(to, buf)) {
+        DEBUGMSG(VERBOSE, "    not enqueued because already there\n");
+        ccnl_buf_release(buf);
+        return -1;
+    }
+    if (to->outqlen >= to->outqmax && ccnl_face_growqueue(to)) {
+        DEBUGMSG(WARNING, "  DROPPING buf=%p\n", (void*)buf);
+        if (to->ifndx >= 0)
+            ccnl->ifs[to->ifndx].drops++;
+        ccnl_buf_release(buf);
+        return -1;
+    }
+    to->outq[(to->outqfront + to->outqlen) % to->outqmax] = buf;
+    to->outqlen++;
+    *ccnl_face_fpfind(to, buf) = buf;
 #ifdef USE_SCHEDULER
     if (to->sched) {
 #ifdef USE_FRAG
@@ -386,8 +784,8 @@ ccnl_interest_new(struct ccnl_relay_s *ccnl, struct ccnl_face_s *from,
                   struct ccnl_buf_s **pkt, struct ccnl_prefix_s **prefix,
                   int minsuffix, int maxsuffix)
 {
-    struct ccnl_interest_s *i = (struct ccnl_interest_s *) ccnl_calloc(1,
-                                            sizeof(struct ccnl_interest_s));
+    struct ccnl_interest_s *i = (struct ccnl_interest_s *)
+        ccnl_calloc_type(CCNL_MEMPOOL_INTEREST, sizeof(struct ccnl_interest_s));
     DEBUGMSG(TRACE, "ccnl_new_interest\n");
 
     if (!i){
@@ -413,10 +811,72 @@ ccnl_interest_new(struct ccnl_relay_s *ccnl, struct ccnl_face_s *from,
 #endif
     }
     i->last_used = CCNL_NOW();
+    i->timer = ccnl_set_timer(CCNL_INTEREST_RETRANSMIT_TIME * 1000000,
+                              ccnl_interest_ageing, ccnl, i);
     DBL_LINKED_LIST_ADD(ccnl->pit, i);
+    ccnl_hashtab_add(&ccnl->pitidx, &i->pitlink,
+                     ccnl_prefix_hash(suite, i->prefix, i->prefix->compcnt), i);
+    if ((suite == CCNL_SUITE_CCNB || suite == CCNL_SUITE_NDNTLV) &&
+        i->prefix->compcnt > 0 &&
+        i->prefix->complen[i->prefix->compcnt - 1] == 32) { // SHA256
+        i->flags |= CCNL_PIT_MAYDIGEST;
+        ccnl->pitmdcnt++;
+    }
     return i;
 }
 
+// sets the lifetime (msec) requested by the interest packet,
+// 0 keeps the default of CCNL_INTEREST_TIMEOUT seconds
+void
+ccnl_interest_setlifetime(struct ccnl_relay_s *ccnl,
+                          struct ccnl_interest_s *i, int lifetime)
+{
+    i->lifetime = lifetime;
+    if (lifetime > 0 && lifetime < CCNL_INTEREST_RETRANSMIT_TIME * 1000) {
+        // expires before the first retransmission
+        ccnl_rem_timer(i->timer);
+        i->timer = ccnl_set_timer(lifetime * 1000, ccnl_interest_ageing,
+                                  ccnl, i);
+    }
+}
+
+// an interest aggregated into the entry i asks for 'lifetime' msec
+// (0: the default): the entry lives on until the later of both ends
+void
+ccnl_interest_extendlifetime(struct ccnl_interest_s *i, int lifetime)
+{
+    double end, cur;
+
+    end = CCNL_NOW() + (lifetime > 0 ? lifetime/1000.0 : CCNL_INTEREST_TIMEOUT);
+    cur = i->last_used + (i->lifetime > 0 ? i->lifetime / 1000.0 :
+                                            CCNL_INTEREST_TIMEOUT);
+    // the timer fires no later than the old end, and is then set again
+    if (end > cur)
+        i->lifetime = (end - i->last_used) * 1000 + 0.5;
+}
+
+// returns the next PIT entry (after 'after', or the first one if NULL)
+// with the same suite and exactly the same name
+struct ccnl_interest_s*
+ccnl_pit_find(struct ccnl_relay_s *ccnl, struct ccnl_interest_s *after,
+              char suite, struct ccnl_prefix_s *p)
+{
+    struct ccnl_hashlink_s *l;
+
+    if (after)
+        l = after->pitlink.obj ? ccnl_hashtab_next(&after->pitlink) : NULL;
+    else
+        l = ccnl_hashtab_first(&ccnl->pitidx,
+                               ccnl_prefix_hash(suite, p, p->compcnt));
+    for (; l; l = ccnl_hashtab_next(l)) {
+        struct ccnl_interest_s *i = (struct ccnl_interest_s*) l->obj;
+        if (i->suite == suite &&
+            !ccnl_prefix_cmp(i->prefix, NULL, p, CMP_EXACT))
+            return i;
+    }
+    return NULL;
+}
+
 int
 ccnl_interest_append_pending(struct ccnl_interest_s *i,
                              struct ccnl_face_s *from)
@@ -432,7 +892,8 @@ ccnl_interest_append_pending(struct ccnl_interest_s *i,
         }
         last = pi;
     }
-    pi = (struct ccnl_pendint_s *) ccnl_calloc(1,sizeof(struct ccnl_pendint_s));
+    pi = (struct ccnl_pendint_s *) ccnl_calloc_type(CCNL_MEMPOOL_PENDINT,
+                                                sizeof(struct ccnl_pendint_s));
     DEBUGMSG(DEBUG, "  appending a new pendint entry %p\n", (void *) pi);
     if (!pi)
         return -1;
@@ -445,11 +906,25 @@ ccnl_interest_append_pending(struct ccnl_interest_s *i,
     return 0;
 }
 
+// adds a FIB entry (with prefix, face and suite already set) to the relay
 void
+ccnl_fib_add(struct ccnl_relay_s *ccnl, struct ccnl_forward_s *fwd)
+{
+    fwd->next = ccnl->fib;
+    ccnl->fib = fwd;
+    ccnl_hashtab_add(&ccnl->fibidx, &fwd->fiblink,
+                     ccnl_prefix_hash(fwd->suite, fwd->prefix,
+                                      fwd->prefix->compcnt), fwd);
+    ccnl->fibgen++;
+}
+
+// returns 1 if the interest was removed (USE_NACK: no face to forward to)
+int
 ccnl_interest_propagate(struct ccnl_relay_s *ccnl, struct ccnl_interest_s *i)
 {
     struct ccnl_forward_s *fwd;
-    int rc = 0;
+    struct ccnl_hashlink_s *l;
+    int rc, k;
 #ifdef USE_NACK
     int matching_face = 0;
 #endif
@@ -459,13 +934,18 @@ ccnl_interest_propagate(struct ccnl_relay_s *ccnl, struct ccnl_interest_s *i)
     // transmit an Interest Message on all listed dest faces in sequence."
     // CCNL strategy: we forward on all FWD entries with a prefix match
 
-    for (fwd = ccnl->fib; fwd; fwd = fwd->next) {
+    // the FIB is indexed by (suite, prefix): probe every prefix of the
+    // interest's name, longest first (the name's cumulative hashes make
+    // each probe O(1))
+    for (k = i->prefix->compcnt; k >= 0; k--)
+      for (l = ccnl_hashtab_first(&ccnl->fibidx,
+                                  ccnl_prefix_hash(i->suite, i->prefix, k));
+                                  l; l = ccnl_hashtab_next(l)) {
+        fwd = (struct ccnl_forward_s*) l->obj;
 
         //Only for matching suite
-        if (fwd->suite != i->suite) {
-            DEBUGMSG(DEBUG, "  not same suite (%d/%d)\n", fwd->suite, i->suite);
+        if (fwd->suite != i->suite || fwd->prefix->compcnt != k)
             continue;
-        }
 
         rc = ccnl_prefix_cmp(fwd->prefix, NULL, i->prefix, CMP_LONGEST);
 
@@ -478,7 +958,7 @@ ccnl_interest_propagate(struct ccnl_relay_s *ccnl, struct ccnl_interest_s *i)
         if (!i->from || fwd->face != i->from ||
                                 (i->from->flags & CCNL_FACE_FLAGS_REFLECT)) {
             ccnl_nfn_monitor(ccnl, fwd->face, i->prefix, NULL, 0);
-            ccnl_face_enqueue(ccnl, fwd->face, buf_dup(i->pkt));
+            ccnl_face_enqueue(ccnl, fwd->face, ccnl_buf_ref(i->pkt));
 #ifdef USE_NACK
             matching_face = 1;
 #endif
@@ -490,10 +970,11 @@ ccnl_interest_propagate(struct ccnl_relay_s *ccnl, struct ccnl_interest_s *i)
     if(!matching_face){
         ccnl_nack_reply(ccnl, i->prefix, i->from, i->suite);
         ccnl_interest_remove(ccnl, i);
+        return 1;
     }
 #endif
 
-    return;
+    return 0;
 }
 
 struct ccnl_interest_s*
@@ -513,8 +994,12 @@ ccnl_interest_remove(struct ccnl_relay_s *ccnl, struct ccnl_interest_s *i)
         ccnl_free(i->pending);
         i->pending = tmp;
     }
+    ccnl_rem_timer(i->timer);
     i2 = i->next;
     DBL_LINKED_LIST_REMOVE(ccnl->pit, i);
+    ccnl_hashtab_remove(&ccnl->pitidx, &i->pitlink);
+    if (i->flags & CCNL_PIT_MAYDIGEST)
+        ccnl->pitmdcnt--;
     free_prefix(i->prefix);
 
     switch (i->suite) {
@@ -530,13 +1015,273 @@ ccnl_interest_remove(struct ccnl_relay_s *ccnl, struct ccnl_interest_s *i)
     default:
         break;
     }
-    free_2ptr_list(i->pkt, i);
+    ccnl_buf_release(i->pkt);
+    ccnl_free(i);
     return i2;
 }
 
+// ----------------------------------------------------------------------
+// content store trie, for suites with prefix matching and min/maxsuffix:
+// a node per name component, children are kept in canonical order
+
+#define ccnl_cstrie_suite(S)    ((S) == CCNL_SUITE_CCNB || \
+                                 (S) == CCNL_SUITE_NDNTLV)
+
+// canonical order: shorter components first, then lexicographic
+static int
+ccnl_cstrie_cmp(unsigned char *c1, int len1, unsigned char *c2, int len2)
+{
+    if (len1 != len2)
+        return len1 < len2 ? -1 : 1;
+    return memcmp(c1, c2, len1);
+}
+
+// binary search, returns the child's index or (-index-1) where to insert it
+static int
+ccnl_cstrie_find(struct ccnl_csnode_s *n, unsigned char *comp, int len)
+{
+    int lo = 0, hi = n->childcnt - 1, mid, rc;
+
+    while (lo <= hi) {
+        mid = (lo + hi) / 2;
+        rc = ccnl_cstrie_cmp(n->child[mid]->comp, n->child[mid]->complen,
+                             comp, len);
+        if (!rc)
+            return mid;
+        if (rc < 0)
+            lo = mid + 1;
+        else
+            hi = mid - 1;
+    }
+    return -lo - 1;
+}
+
+static struct ccnl_csnode_s*
+ccnl_cstrie_newnode(struct ccnl_csnode_s *parent, unsigned char *comp, int len)
+{
+    struct ccnl_csnode_s *n;
+
+    n = (struct ccnl_csnode_s*) ccnl_calloc(1, sizeof(*n) + len);
+    if (!n)
+        return NULL;
+    n->parent = parent;
+    n->complen = len;
+    if (len)
+        memcpy(n->comp, comp, len);
+    return n;
+}
+
+// unlinks c from its trie node and frees all nodes which became empty
+void
+ccnl_cstrie_remove(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c)
+{
+    struct ccnl_csnode_s *n = c->csnode, *p;
+    struct ccnl_content_s **cpp;
+    int k;
+
+    if (!n)
+        return;
+    for (cpp = &n->contents; *cpp; cpp = &(*cpp)->csnodenext)
+        if (*cpp == c) {
+            *cpp = c->csnodenext;
+            break;
+        }
+    c->csnode = NULL;
+    c->csnodenext = NULL;
+    while (n && !n->contents && !n->childcnt) {
+        p = n->parent;
+        if (p) {
+            k = ccnl_cstrie_find(p, n->comp, n->complen);
+            if (k >= 0) {
+                p->childcnt--;
+                memmove(p->child + k, p->child + k + 1,
+                        (p->childcnt - k) * sizeof(*p->child));
+            }
+        } else
+            ccnl->cstrie[(int)c->suite] = NULL;
+        ccnl_free(n->child);
+        ccnl_free(n);
+        n = p;
+    }
+}
+
+void
+ccnl_cstrie_add(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c)
+{
+    struct ccnl_csnode_s *n = ccnl->cstrie[(int)c->suite], *n2;
+    int i, k;
+
+    if (!n) {
+        n = ccnl->cstrie[(int)c->suite] = ccnl_cstrie_newnode(NULL, NULL, 0);
+        if (!n)
+            return;
+    }
+    for (i = 0; i < c->name->compcnt; i++, n = n2) {
+        k = ccnl_cstrie_find(n, c->name->comp[i], c->name->complen[i]);
+        if (k >= 0) {
+            n2 = n->child[k];
+            continue;
+        }
+        k = -k - 1;
+        if (n->childcnt == n->childmax) {
+            int max = n->childmax ? 2 * n->childmax : 4;
+            struct ccnl_csnode_s **ch;
+            ch = (struct ccnl_csnode_s**) ccnl_malloc(max * sizeof(*ch));
+            if (!ch)
+                break;
+            if (n->childcnt)
+                memcpy(ch, n->child, n->childcnt * sizeof(*ch));
+            ccnl_free(n->child);
+            n->child = ch;
+            n->childmax = max;
+        }
+        n2 = ccnl_cstrie_newnode(n, c->name->comp[i], c->name->complen[i]);
+        if (!n2)
+            break;
+        memmove(n->child + k + 1, n->child + k,
+                (n->childcnt - k) * sizeof(*n->child));
+        n->child[k] = n2;
+        n->childcnt++;
+    }
+    if (i < c->name->compcnt) { // out of memory, leave c unindexed
+        DEBUGMSG(ERROR, "ccnl_cstrie_add: no memory, content not indexed\n");
+        c->csnode = n;
+        ccnl_cstrie_remove(ccnl, c);
+        return;
+    }
+    c->csnode = n;
+    c->csnodenext = n->contents;
+    n->contents = c;
+}
+
+static int
+ccnl_cstrie_accept(struct ccnl_content_s *c, struct ccnl_prefix_s *p,
+                   int minsfx, int maxsfx, int mbf, struct ccnl_buf_s *ppk)
+{
+    if (mbf && (c->flags & CCNL_CONTENT_FLAGS_STALE))
+        return 0;
+    if (!ccnl_i_prefixof_c(p, minsfx, maxsfx, c))
+        return 0;
+    if (!ppk)
+        return 1;
+    switch (c->suite) {
+#ifdef USE_SUITE_CCNB
+    case CCNL_SUITE_CCNB:
+        return buf_equal(ppk, c->details.ccnb.ppkd);
+#endif
+#ifdef USE_SUITE_NDNTLV
+    case CCNL_SUITE_NDNTLV:
+        return buf_equal(ppk, c->details.ndntlv.ppkl);
+#endif
+    default:
+        break;
+    }
+    return 0;
+}
+
+// depth first search in canonical order, only descending as long as
+// the number of name components fits the interest's maxsuffix
+static struct ccnl_content_s*
+ccnl_cstrie_dfs(struct ccnl_csnode_s *n, int depth, struct ccnl_prefix_s *p,
+                int minsfx, int maxsfx, int mbf, struct ccnl_buf_s *ppk)
+{
+    struct ccnl_content_s *c;
+    int k;
+
+    // content at this depth has (depth + 1 - p->compcnt) suffix components
+    if (depth + 1 - p->compcnt >= minsfx)
+        for (c = n->contents; c; c = c->csnodenext)
+            if (ccnl_cstrie_accept(c, p, minsfx, maxsfx, mbf, ppk))
+                return c;
+    if (depth + 2 - p->compcnt > maxsfx)
+        return NULL;
+    for (k = 0; k < n->childcnt; k++) {
+        c = ccnl_cstrie_dfs(n->child[k], depth + 1, p, minsfx, maxsfx, mbf,
+                            ppk);
+        if (c)
+            return c;
+    }
+    return NULL;
+}
+
+// indexes cached content by name and implicit digest, once the digest
+// is known (see ccnl_content_digest())
+static void
+ccnl_cs_mdindex(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c)
+{
+    if (!(c->flags & CCNL_CONTENT_FLAGS_MD) || !c->cslink.obj ||
+                                                            c->mdlink.obj)
+        return;
+    ccnl_hashtab_add(&ccnl->csmdidx, &c->mdlink,
+                     ccnl_prefix_hash_md(c->suite, c->name, c->md), c);
+}
+
+// returns the leftmost (in canonical order) cached content matching
+// the interest's prefix and min/maxsuffix (and publisher key, if given),
+// skipping stale content if the interest asks for fresh content (mbf)
+struct ccnl_content_s*
+ccnl_cstrie_lookup(struct ccnl_relay_s *ccnl, int suite,
+                   struct ccnl_prefix_s *p, int minsfx, int maxsfx, int mbf,
+                   struct ccnl_buf_s *ppk)
+{
+    struct ccnl_csnode_s *n = ccnl->cstrie[suite];
+    struct ccnl_hashlink_s *l;
+    struct ccnl_content_s *c;
+    int i, k, rc;
+
+    for (i = 0; n && i < p->compcnt; i++) {
+        if (i == p->compcnt - 1 && minsfx <= 0 &&
+                                        p->complen[i] == 32) { // SHA256
+            // the last component could be the implicit digest: content
+            // with a known digest is found through the digest index, the
+            // digest of the others is computed (and indexed) here
+            l = ccnl_hashtab_first(&ccnl->csmdidx,
+                                   ccnl_prefix_hash(suite, p, p->compcnt));
+            for (; l; l = ccnl_hashtab_next(l)) {
+                c = (struct ccnl_content_s*) l->obj;
+                if (ccnl_cstrie_accept(c, p, minsfx, maxsfx, mbf, ppk))
+                    return c;
+            }
+            for (c = n->contents; c; c = c->csnodenext) {
+                if (c->flags & CCNL_CONTENT_FLAGS_MD)
+                    continue;
+                rc = ccnl_cstrie_accept(c, p, minsfx, maxsfx, mbf, ppk);
+                ccnl_cs_mdindex(ccnl, c);
+                if (rc)
+                    return c;
+            }
+        }
+        k = ccnl_cstrie_find(n, p->comp[i], p->complen[i]);
+        n = k >= 0 ? n->child[k] : NULL;
+    }
+    if (!n)
+        return NULL;
+    return ccnl_cstrie_dfs(n, p->compcnt, p, minsfx, maxsfx, mbf, ppk);
+}
+
+// ----------------------------------------------------------------------
+
+#include "ccnl-core-cache.c"
+
 // ----------------------------------------------------------------------
 // handling of content messages
 
+// the implicit digest of c (or NULL if not supported), computed once
+unsigned char*
+ccnl_content_digest(struct ccnl_content_s *c)
+{
+    unsigned char *md;
+
+    if (c->flags & CCNL_CONTENT_FLAGS_MD)
+        return c->md;
+    md = compute_ccnx_digest(c->pkt);
+    if (!md)
+        return NULL;
+    memcpy(c->md, md, sizeof(c->md));
+    c->flags |= CCNL_CONTENT_FLAGS_MD;
+    return c->md;
+}
+
 int
 ccnl_i_prefixof_c(struct ccnl_prefix_s *prefix,
                   int minsuffix, int maxsuffix, struct ccnl_content_s *c)
@@ -555,7 +1300,7 @@ ccnl_i_prefixof_c(struct ccnl_prefix_s *prefix,
          (prefix->compcnt + maxsuffix) < (c->name->compcnt + 1) )
         return 0;
 
-    md = prefix->compcnt - c->name->compcnt == 1 ? compute_ccnx_digest(c->pkt) : NULL;
+    md = prefix->compcnt - c->name->compcnt == 1 ? ccnl_content_digest(c) : NULL;
     return ccnl_prefix_cmp(c->name, md, prefix, CMP_MATCH) == prefix->compcnt;
 }
 
@@ -569,9 +1314,11 @@ ccnl_content_new(struct ccnl_relay_s *ccnl, char suite, struct ccnl_buf_s **pkt,
              prefix==NULL ? NULL : ccnl_prefix_to_path(*prefix),
              contlen, *pkt ? (*pkt)->datalen : -1);
 
-    c = (struct ccnl_content_s *) ccnl_calloc(1, sizeof(struct ccnl_content_s));
+    c = (struct ccnl_content_s *) ccnl_calloc_type(CCNL_MEMPOOL_CONTENT,
+                                                sizeof(struct ccnl_content_s));
     if (!c) return NULL;
     c->suite = suite;
+    c->freshness = -1;
     c->last_used = CCNL_NOW();
     c->content = content;
     c->contentlen = contlen;
@@ -594,6 +1341,32 @@ ccnl_content_new(struct ccnl_relay_s *ccnl, char suite, struct ccnl_buf_s **pkt,
     return c;
 }
 
+// memory accounted for a cached content object (packet and metadata)
+static int
+ccnl_content_size(struct ccnl_content_s *c)
+{
+    int i, size = sizeof(*c);
+
+    if (c->pkt)
+        size += sizeof(struct ccnl_buf_s) + c->pkt->datalen;
+    if (c->name) {
+        size += sizeof(struct ccnl_prefix_s) + c->name->compcnt *
+            (sizeof(unsigned char*) + sizeof(int) + sizeof(unsigned int));
+        if (c->name->bytes)
+            for (i = 0; i < c->name->compcnt; i++)
+                size += c->name->complen[i];
+    }
+    return size;
+}
+
+// to be called on every cache hit
+void
+ccnl_content_used(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c)
+{
+    c->last_used = CCNL_NOW();
+    ccnl_cache_hit(ccnl, c);
+}
+
 struct ccnl_content_s*
 ccnl_content_remove(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c)
 {
@@ -602,6 +1375,12 @@ ccnl_content_remove(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c)
 
     c2 = c->next;
     DBL_LINKED_LIST_REMOVE(ccnl->contents, c);
+    ccnl_hashtab_remove(&ccnl->csidx, &c->cslink);
+    ccnl_hashtab_remove(&ccnl->csmdidx, &c->mdlink);
+    ccnl_cstrie_remove(ccnl, c);
+    ccnl_cache_remove(ccnl, c);
+    ccnl_rem_timer(c->timer);
+    ccnl->contentbytes -= c->size;
     free_content(c);
     ccnl->contentcnt--;
     return c2;
@@ -610,109 +1389,148 @@ ccnl_content_remove(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c)
 struct ccnl_content_s*
 ccnl_content_add2cache(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c)
 {
-    struct ccnl_content_s *cit;
     DEBUGMSG(DEBUG, "ccnl_content_add2cache (%d/%d) --> %p\n",
              ccnl->contentcnt, ccnl->max_cache_entries, (void*)c);
-    for (cit = ccnl->contents; cit; cit = cit->next) {
-        if (c == cit) {
-            DEBUGMSG(DEBUG, "--- Already in cache ---\n");
-            return NULL;
-        }
+    if (c->cslink.obj) {
+        DEBUGMSG(DEBUG, "--- Already in cache ---\n");
+        return NULL;
     }
 #ifdef USE_NACK
     if (ccnl_nfnprefix_contentIsNACK(c))
         return NULL;
 #endif
-    if (ccnl->max_cache_entries > 0 &&
-        ccnl->contentcnt >= ccnl->max_cache_entries) { // remove oldest content
-        struct ccnl_content_s *c2;
-        int age = 0;
-        for (c2 = ccnl->contents; c2; c2 = c2->next)
-            if (!(c2->flags & CCNL_CONTENT_FLAGS_STATIC) &&
-                                        ((age == 0) || c2->last_used < age))
-                age = c2->last_used;
-        if (c2)
-            ccnl_content_remove(ccnl, c2);
+    c->size = ccnl_content_size(c);
+    c->cslink.hash = ccnl_prefix_hash(c->suite, c->name, c->name->compcnt);
+    ccnl_cache_admit(ccnl, c);
+    while ((ccnl->max_cache_entries > 0 &&
+            ccnl->contentcnt >= ccnl->max_cache_entries) ||
+           (ccnl->max_cache_bytes > 0 &&
+            ccnl->contentbytes + c->size > ccnl->max_cache_bytes)) {
+        // ask the replacement policy
+        struct ccnl_content_s *c2 = ccnl_cache_victim(ccnl);
+        if (!c2) // only static content left, we have to exceed the limit
+            break;
+        ccnl_content_remove(ccnl, c2);
     }
     DBL_LINKED_LIST_ADD(ccnl->contents, c);
+    ccnl_hashtab_add(&ccnl->csidx, &c->cslink, c->cslink.hash, c);
+    ccnl_cs_mdindex(ccnl, c);
+    ccnl_cache_insert(ccnl, c);
+    if (c->freshness >= 0) {
+        c->fresh_until = CCNL_NOW() + c->freshness / 1000.0;
+        c->timer = ccnl_set_timer(c->freshness < CCNL_CONTENT_TIMEOUT * 1000 ?
+                                  c->freshness * 1000 :
+                                  CCNL_CONTENT_TIMEOUT * 1000000,
+                                  ccnl_content_ageing, ccnl, c);
+    } else
+        c->timer = ccnl_set_timer(CCNL_CONTENT_TIMEOUT * 1000000,
+                                  ccnl_content_ageing, ccnl, c);
+    if (ccnl_cstrie_suite(c->suite))
+        ccnl_cstrie_add(ccnl, c);
     ccnl->contentcnt++;
+    ccnl->contentbytes += c->size;
+    if (ccnl->contentbytes > ccnl->contentbytes_peak)
+        ccnl->contentbytes_peak = ccnl->contentbytes;
     return c;
 }
 
-// deliver new content c to all clients with (loosely) matching interest,
-// but only one copy per face
-// returns: number of forwards
-int
-ccnl_content_serve_pending(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c)
+// a fresh copy of stale cached content was received
+void
+ccnl_content_refresh(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c)
 {
-    struct ccnl_interest_s *i;
-    struct ccnl_face_s *f;
-    int cnt = 0;
-    DEBUGMSG(TRACE, "ccnl_content_serve_pending\n");
+    c->flags &= ~CCNL_CONTENT_FLAGS_STALE;
+    c->fresh_until = CCNL_NOW() + c->freshness / 1000.0;
+    ccnl_content_used(ccnl, c);
+    ccnl_rem_timer(c->timer);
+    ccnl_content_ageing(ccnl, c); // sets the timer again
+}
+
+// returns the next cached content (after 'after', or the first one if NULL)
+// with the same suite and exactly the same name
+struct ccnl_content_s*
+ccnl_cs_find(struct ccnl_relay_s *ccnl, struct ccnl_content_s *after,
+             char suite, struct ccnl_prefix_s *p)
+{
+    struct ccnl_hashlink_s *l;
 
-    for (f = ccnl->faces; f; f = f->next){
-                f->flags &= ~CCNL_FACE_FLAGS_SERVED; // reply on a face only once
+    if (after)
+        l = after->cslink.obj ? ccnl_hashtab_next(&after->cslink) : NULL;
+    else
+        l = ccnl_hashtab_first(&ccnl->csidx,
+                               ccnl_prefix_hash(suite, p, p->compcnt));
+    for (; l; l = ccnl_hashtab_next(l)) {
+        struct ccnl_content_s *c = (struct ccnl_content_s*) l->obj;
+        if (c->suite == suite &&
+            !ccnl_prefix_cmp(c->name, NULL, p, CMP_EXACT))
+            return c;
     }
-    for (i = ccnl->pit; i;) {
-        struct ccnl_pendint_s *pi;
+    return NULL;
+}
 
-        switch (i->suite) {
+// whether PIT entry i asks for content c
+static int
+ccnl_interest_matches(struct ccnl_interest_s *i, struct ccnl_content_s *c)
+{
+    if (i->suite != c->suite)
+        return 0;
+    switch (i->suite) {
 #ifdef USE_SUITE_CCNB
-        case CCNL_SUITE_CCNB:
-            if (!ccnl_i_prefixof_c(i->prefix, i->details.ccnb.minsuffix,
-                       i->details.ccnb.maxsuffix, c)) {
-                // XX must also check i->ppkd
-                i = i->next;
-                continue;
-            }
-            break;
+    case CCNL_SUITE_CCNB:
+        // XX must also check i->ppkd
+        return ccnl_i_prefixof_c(i->prefix, i->details.ccnb.minsuffix,
+                                 i->details.ccnb.maxsuffix, c);
 #endif
 #ifdef USE_SUITE_CCNTLV
-        case CCNL_SUITE_CCNTLV:
-            if (ccnl_prefix_cmp(c->name, NULL, i->prefix, CMP_EXACT)) {
-                // XX must also check keyid
-                i = i->next;
-                continue;
-            }
-            break;
+    case CCNL_SUITE_CCNTLV:
+        // XX must also check keyid
+        return !ccnl_prefix_cmp(c->name, NULL, i->prefix, CMP_EXACT);
 #endif
 #ifdef USE_SUITE_IOTTLV
-        case CCNL_SUITE_IOTTLV:
-            if (ccnl_prefix_cmp(c->name, NULL, i->prefix, CMP_EXACT)) {
-                // XX must also check keyid
-                i = i->next;
-                continue;
-            }
-            break;
+    case CCNL_SUITE_IOTTLV:
+        // XX must also check keyid
+        return !ccnl_prefix_cmp(c->name, NULL, i->prefix, CMP_EXACT);
 #endif
 #ifdef USE_SUITE_NDNTLV
-        case CCNL_SUITE_NDNTLV:
-            if (!ccnl_i_prefixof_c(i->prefix, i->details.ndntlv.minsuffix,
-                       i->details.ndntlv.maxsuffix, c)) {
-                // XX must also check i->ppkl,
-                i = i->next;
-                continue;
-            }
-            break;
+    case CCNL_SUITE_NDNTLV:
+        // XX must also check i->ppkl,
+        return ccnl_i_prefixof_c(i->prefix, i->details.ndntlv.minsuffix,
+                                 i->details.ndntlv.maxsuffix, c);
 #endif
-        default:
-            i = i->next;
+    default:
+        return 0;
+    }
+}
+
+// serves the PIT entries with the given name hash which match c,
+// returns -1 if c went to a local callback instead
+static int
+ccnl_content_serve_bucket(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c,
+                          unsigned int hash)
+{
+    struct ccnl_hashlink_s *l, *next;
+    struct ccnl_interest_s *i;
+    struct ccnl_pendint_s *pi;
+    int cnt = 0;
+
+    for (l = ccnl_hashtab_first(&ccnl->pitidx, hash); l; l = next) {
+        next = ccnl_hashtab_next(l);
+        i = (struct ccnl_interest_s*) l->obj;
+        if (!ccnl_interest_matches(i, c))
             continue;
-        }
 
         //Hook for add content to cache by callback:
-        if(i && ! i->pending){
+        if (!i->pending) {
             c->flags |= CCNL_CONTENT_FLAGS_STATIC;
-            i = ccnl_interest_remove(ccnl, i);
-            return 1;
+            ccnl_interest_remove(ccnl, i);
+            return -1;
         }
 
         // CONFORM: "Data MUST only be transmitted in response to
         // an Interest that matches the Data."
         for (pi = i->pending; pi; pi = pi->next) {
-            if (pi->face->flags & CCNL_FACE_FLAGS_SERVED)
-            continue;
-            pi->face->flags |= CCNL_FACE_FLAGS_SERVED;
+            if (pi->face->servedepoch == ccnl->serveepoch)
+                continue; // reply on a face only once
+            pi->face->servedepoch = ccnl->serveepoch;
             if (pi->face->ifndx >= 0) {
                 DEBUGMSG(DEBUG, "  forwarding content <%s>\n",
                          ccnl_prefix_to_path(c->name));
@@ -721,86 +1539,235 @@ ccnl_content_serve_pending(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c)
                          pi->face->faceid, (void*) c->pkt);
                 ccnl_nfn_monitor(ccnl, pi->face, c->name,
                                  c->content, c->contentlen);
-                ccnl_face_enqueue(ccnl, pi->face, buf_dup(c->pkt));
+                ccnl_face_enqueue(ccnl, pi->face, ccnl_buf_ref(c->pkt));
             } else {// upcall to deliver content to local client
                 ccnl_app_RX(ccnl, c);
             }
             c->served_cnt++;
             cnt++;
         }
-        i = ccnl_interest_remove(ccnl, i);
+        ccnl_interest_remove(ccnl, i);
     }
     return cnt;
 }
 
+// returns the cached content with the same suite and name, and exactly
+// the same packet as pkt
+struct ccnl_content_s*
+ccnl_cs_findpkt(struct ccnl_relay_s *ccnl, char suite, struct ccnl_prefix_s *p,
+                struct ccnl_buf_s *pkt)
+{
+    struct ccnl_content_s *c = NULL;
+
+    while ((c = ccnl_cs_find(ccnl, c, suite, p)))
+        if (ccnl_buf_same(c->pkt, pkt))
+            return c;
+    return NULL;
+}
+
+// deliver new content c to all clients with (loosely) matching interest,
+// but only one copy per face
+// returns: number of forwards
+//
+// Instead of scanning the PIT, the PIT index is probed with the names a
+// matching interest can have: the exact name for CCNx TLV and IOT, and
+// each prefix of the name (plus the name with the implicit digest, if
+// an interest may carry one) for CCNB and NDN. A face gets one copy per
+// call: it is marked with the call's epoch.
+int
+ccnl_content_serve_pending(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c)
+{
+    struct ccnl_prefix_s *name = c->name;
+    unsigned char *md;
+    int k, rc, cnt = 0;
+    DEBUGMSG(TRACE, "ccnl_content_serve_pending\n");
+
+    if (!ccnl->pit)
+        return 0;
+    if (++ccnl->serveepoch == 0) { // wrapped: forget all earlier epochs
+        struct ccnl_face_s *f;
+        for (f = ccnl->faces; f; f = f->next)
+            f->servedepoch = 0;
+        ccnl->serveepoch = 1;
+    }
+
+    switch (c->suite) {
+    case CCNL_SUITE_CCNB:
+    case CCNL_SUITE_NDNTLV:
+        if (ccnl->pitmdcnt > 0 && (md = ccnl_content_digest(c))) {
+            rc = ccnl_content_serve_bucket(ccnl, c,
+                                   ccnl_prefix_hash_md(c->suite, name, md));
+            if (rc < 0)
+                return 1;
+            cnt += rc;
+        }
+        for (k = name->compcnt; k >= 0 && ccnl->pit; k--) {
+            rc = ccnl_content_serve_bucket(ccnl, c,
+                                   ccnl_prefix_hash(c->suite, name, k));
+            if (rc < 0)
+                return 1;
+            cnt += rc;
+        }
+        break;
+    default:
+        rc = ccnl_content_serve_bucket(ccnl, c,
+                       ccnl_prefix_hash(c->suite, name, name->compcnt));
+        if (rc < 0)
+            return 1;
+        cnt += rc;
+        break;
+    }
+    return cnt;
+}
+
+// Each face, PIT entry and cached content has its own timer. Using an
+// entry only updates its last_used field: the timer checks this when it
+// fires and, if the entry is still alive, is set again for the remainder.
+
 void
-ccnl_do_ageing(void *ptr, void *dummy)
-{
-    struct ccnl_relay_s *relay = (struct ccnl_relay_s*) ptr;
-    struct ccnl_content_s *c = relay->contents;
-    struct ccnl_interest_s *i = relay->pit;
-    struct ccnl_face_s *f = relay->faces;
-    time_t t = CCNL_NOW();
-    DEBUGMSG(TRACE, "ageing t=%d\n", (int)t);
-
-    while (c) {
-        if ((c->last_used + CCNL_CONTENT_TIMEOUT) <= t &&
-                                !(c->flags & CCNL_CONTENT_FLAGS_STATIC))
-            c = ccnl_content_remove(relay, c);
-        else
-            c = c->next;
-    }
-    while (i) { // CONFORM: "Entries in the PIT MUST timeout rather
-                // than being held indefinitely."
-        if ((i->last_used + CCNL_INTEREST_TIMEOUT) <= t ||
-                                i->retries > CCNL_MAX_INTEREST_RETRANSMIT) {
-            i = ccnl_nfn_interest_remove(relay, i);
-        } else {
-            // CONFORM: "A node MUST retransmit Interest Messages
-            // periodically for pending PIT entries."
-            DEBUGMSG(DEBUG, " retransmit %d <%s>\n", i->retries,
-                     ccnl_prefix_to_path(i->prefix));
+ccnl_face_ageing(void *relay, void *aux)
+{
+    struct ccnl_face_s *f = (struct ccnl_face_s*) aux;
+    double left = f->last_used + CCNL_FACE_TIMEOUT - CCNL_NOW();
+
+    f->timer = NULL;
+    if (f->flags & CCNL_FACE_FLAGS_STATIC)
+        return;
+    if (left > 0)
+        f->timer = ccnl_set_timer(left * 1000000, ccnl_face_ageing, relay, f);
+    else
+        ccnl_face_remove((struct ccnl_relay_s*) relay, f);
+}
+
+void
+ccnl_interest_ageing(void *relay, void *aux)
+{
+    struct ccnl_interest_s *i = (struct ccnl_interest_s*) aux;
+    double left = i->last_used - CCNL_NOW() + (i->lifetime > 0 ?
+                        i->lifetime / 1000.0 : CCNL_INTEREST_TIMEOUT);
+
+    i->timer = NULL;
+    // CONFORM: "Entries in the PIT MUST timeout rather
+    // than being held indefinitely."
+    if (left <= 0) {
+        ccnl_nfn_interest_remove((struct ccnl_relay_s*) relay, i);
+        return;
+    }
+    // CONFORM: "A node MUST retransmit Interest Messages
+    // periodically for pending PIT entries."
+    // >> CCNL: up to CCNL_MAX_INTEREST_RETRANSMIT+1 times, then the
+    //    entry just waits for its lifetime to end <<
+    if (i->retries <= CCNL_MAX_INTEREST_RETRANSMIT) {
+        DEBUGMSG(DEBUG, " retransmit %d <%s>\n", i->retries,
+                 ccnl_prefix_to_path(i->prefix));
 #ifdef USE_NFN
-            if (i->flags & CCNL_PIT_COREPROPAGATES)
+        if (i->flags & CCNL_PIT_COREPROPAGATES)
 #endif
-                ccnl_interest_propagate(relay, i);
+            if (ccnl_interest_propagate((struct ccnl_relay_s*) relay, i))
+                return;
+        i->retries++;
+        if (left > CCNL_INTEREST_RETRANSMIT_TIME)
+            left = CCNL_INTEREST_RETRANSMIT_TIME;
+    }
+    if (left > CCNL_TIMER_MAXSEC) // beyond what ccnl_set_timer() can count
+        left = CCNL_TIMER_MAXSEC;
+    i->timer = ccnl_set_timer(left * 1000000, ccnl_interest_ageing, relay, i);
+}
 
-            i->retries++;
-            i = i->next;
+// marks content as stale when its freshness period is over, and removes
+// it when it was not used for CCNL_CONTENT_TIMEOUT seconds
+void
+ccnl_content_ageing(void *relay, void *aux)
+{
+    struct ccnl_content_s *c = (struct ccnl_content_s*) aux;
+    double now = CCNL_NOW(), left = -1;
+
+    c->timer = NULL;
+    if (c->freshness >= 0 && !(c->flags & CCNL_CONTENT_FLAGS_STALE)) {
+        left = c->fresh_until - now;
+        if (left <= 0) {
+            DEBUGMSG(DEBUG, "  content <%s> is stale\n",
+                     ccnl_prefix_to_path(c->name));
+            c->flags |= CCNL_CONTENT_FLAGS_STALE;
+            left = -1;
         }
     }
-    while (f) {
-        if (!(f->flags & CCNL_FACE_FLAGS_STATIC) &&
-                (f->last_used + CCNL_FACE_TIMEOUT) <= t){
-            f = ccnl_face_remove(relay, f);   
+    if (!(c->flags & CCNL_CONTENT_FLAGS_STATIC)) {
+        double unused = c->last_used + CCNL_CONTENT_TIMEOUT - now;
+        if (unused <= 0) {
+            ccnl_content_remove((struct ccnl_relay_s*) relay, c);
+            return;
+        }
+        if (left < 0 || unused < left)
+            left = unused;
     }
-        else
-            f = f->next;
+    if (left > CCNL_CONTENT_TIMEOUT)
+        left = CCNL_CONTENT_TIMEOUT;
+    if (left > 0)
+        c->timer = ccnl_set_timer(left * 1000000, ccnl_content_ageing,
+                                  relay, c);
+}
+
+static int
+ccnl_nonce_init(struct ccnl_relay_s *ccnl)
+{
+    struct ccnl_nonceset_s *s = &ccnl->nonces;
+    int i, n;
+
+    s->max = ccnl->max_nonces > 0 ? ccnl->max_nonces : CCNL_MAX_NONCES;
+    for (n = 1; n < s->max; n *= 2);
+    s->ring = (struct ccnl_nonce_s*) ccnl_malloc(s->max * sizeof(*s->ring));
+    s->bucket = (int*) ccnl_malloc(n * sizeof(int));
+    if (!s->ring || !s->bucket) {
+        DEBUGMSG(ERROR, "no memory for the nonce table\n");
+        ccnl_free(s->ring);
+        ccnl_free(s->bucket);
+        s->ring = NULL;
+        s->bucket = NULL;
+        return -1;
     }
+    for (i = 0; i < n; i++)
+        s->bucket[i] = -1;
+    s->mask = n - 1;
+    s->cnt = s->head = 0;
+    return 0;
 }
 
+// returns -1 if the nonce was seen recently, otherwise records it
 int
 ccnl_nonce_find_or_append(struct ccnl_relay_s *ccnl, struct ccnl_buf_s *nonce)
 {
-    struct ccnl_buf_s *n, *n2 = 0;
-    int i;
+    struct ccnl_nonceset_s *s = &ccnl->nonces;
+    struct ccnl_nonce_s *e;
+    unsigned int h;
+    int i, *pp, len = nonce->datalen;
     DEBUGMSG(TRACE, "ccnl_nonce_find_or_append\n");
 
-    for (n = ccnl->nonces, i = 0; n; n = n->next, i++) {
-        if (buf_equal(n, nonce))
+    if (!s->ring && ccnl_nonce_init(ccnl))
+        return 0;
+    if (len > CCNL_MAX_NONCE_LEN)
+        len = CCNL_MAX_NONCE_LEN;
+    h = ccnl_hash_bytes(ccnl_hash_init(0), nonce->data, nonce->datalen);
+    for (i = s->bucket[h & s->mask]; i >= 0; i = s->ring[i].next) {
+        e = s->ring + i;
+        if (e->hash == h && e->len == nonce->datalen &&
+                                            !memcmp(e->data, nonce->data, len))
             return -1;
-        if (n->next)
-            n2 = n;
-    }
-    n = ccnl_buf_new(nonce->data, nonce->datalen);
-    if (n) {
-        n->next = ccnl->nonces;
-        ccnl->nonces = n;
-        if (i >= CCNL_MAX_NONCES && n2) {
-            ccnl_free(n2->next);
-            n2->next = 0;
-        }
     }
+
+    e = s->ring + s->head;
+    if (s->cnt == s->max) { // the oldest nonce has to go
+        for (pp = s->bucket + (e->hash & s->mask); *pp != s->head;
+                                                pp = &s->ring[*pp].next);
+        *pp = e->next;
+    } else
+        s->cnt++;
+    e->hash = h;
+    e->len = nonce->datalen;
+    memcpy(e->data, nonce->data, len);
+    e->next = s->bucket[h & s->mask];
+    s->bucket[h & s->mask] = s->head;
+    s->head = (s->head + 1) % s->max;
     return 0;
 }
 
@@ -819,22 +1786,52 @@ ccnl_nonce_find_or_append(struct ccnl_relay_s *ccnl, struct ccnl_buf_s *nonce)
 
 typedef int (*dispatchFct)(struct ccnl_relay_s*, struct ccnl_face_s*,
                            unsigned char**, int*);
-dispatchFct ccnl_core_RX_dispatch[CCNL_SUITE_LAST];
+
+static dispatchFct
+ccnl_core_RX_dispatch(int suite)
+{
+    switch (suite) {
+#ifdef USE_SUITE_CCNB
+    case CCNL_SUITE_CCNB:
+        return ccnl_ccnb_forwarder;
+#endif
+#ifdef USE_SUITE_CCNTLV
+    case CCNL_SUITE_CCNTLV:
+        return ccnl_ccntlv_forwarder;
+#endif
+#ifdef USE_SUITE_IOTTLV
+    case CCNL_SUITE_IOTTLV:
+        return ccnl_iottlv_forwarder;
+#endif
+#ifdef USE_SUITE_LOCALRPC
+    case CCNL_SUITE_LOCALRPC:
+        return ccnl_localrpc_exec;
+#endif
+#ifdef USE_SUITE_NDNTLV
+    case CCNL_SUITE_NDNTLV:
+        return ccnl_ndntlv_forwarder;
+#endif
+    default:
+        return NULL;
+    }
+}
 
 void
 ccnl_core_RX(struct ccnl_relay_s *relay, int ifndx, unsigned char *data,
              int datalen, struct sockaddr *sa, int addrlen)
 {
     unsigned char *base = data;
+    struct ccnl_timerq_s *prevq;
     struct ccnl_face_s *from;
     int enc, suite = -1, skip;
     dispatchFct dispatch;
 
     DEBUGMSG(DEBUG, "ccnl_core_RX ifndx=%d, %d bytes\n", ifndx, datalen);
 
+    prevq = ccnl_timerq_select(relay->timerq);
     from = ccnl_get_face_or_create(relay, ifndx, sa, addrlen);
     if (!from)
-        return;
+        goto done;
 
     // loop through all packets in the received frame (UDP, Ethernet etc)
     while (datalen > 0) {
@@ -847,13 +1844,13 @@ ccnl_core_RX(struct ccnl_relay_s *relay, int ifndx, unsigned char *data,
         if (suite < 0 || suite >= CCNL_SUITE_LAST) {
             DEBUGMSG(WARNING, "?unknown packet format? ccnl_core_RX ifndx=%d, %d bytes starting with 0x%02x at offset %zd\n",
                      ifndx, datalen, *data, data - base);
-            return;
+            break;
         }
-        dispatch = ccnl_core_RX_dispatch[suite];
+        dispatch = ccnl_core_RX_dispatch(suite);
         if (!dispatch) {
-            DEBUGMSG(ERROR, "Forwarder not initialized or dispatcher "
-                     "for suite %s does not exist.\n", ccnl_suite2str(suite));
-            return;
+            DEBUGMSG(ERROR, "Forwarder for suite %s is not compiled in.\n",
+                     ccnl_suite2str(suite));
+            break;
         }
         if (dispatch(relay, from, &data, &datalen) < 0)
             break;
@@ -861,6 +1858,8 @@ ccnl_core_RX(struct ccnl_relay_s *relay, int ifndx, unsigned char *data,
             DEBUGMSG(WARNING, "ccnl_core_RX: %d bytes left\n", datalen);
         }
     }
+done:
+    (void) ccnl_timerq_select(prevq);
 }
 
 // ----------------------------------------------------------------------
@@ -868,28 +1867,15 @@ ccnl_core_RX(struct ccnl_relay_s *relay, int ifndx, unsigned char *data,
 void
 ccnl_core_init(void)
 {
-#ifdef USE_SUITE_CCNB
-    ccnl_core_RX_dispatch[CCNL_SUITE_CCNB]     = ccnl_ccnb_forwarder;
-#endif
-#ifdef USE_SUITE_CCNTLV
-    ccnl_core_RX_dispatch[CCNL_SUITE_CCNTLV]   = ccnl_ccntlv_forwarder;
-#endif
-#ifdef USE_SUITE_IOTTLV
-    ccnl_core_RX_dispatch[CCNL_SUITE_IOTTLV]   = ccnl_iottlv_forwarder;
-#endif
-#ifdef USE_SUITE_LOCALRPC
-    ccnl_core_RX_dispatch[CCNL_SUITE_LOCALRPC] = ccnl_localrpc_exec;
-#endif
-#ifdef USE_SUITE_NDNTLV
-    ccnl_core_RX_dispatch[CCNL_SUITE_NDNTLV]   = ccnl_ndntlv_forwarder;
-#endif
-
+    // the first reading fixes the clock's origin, take it before there
+    // are relays in other threads
+    (void) CCNL_NOW();
 #ifdef USE_NFN
     ZAM_init();
 #endif
 }
 
-struct ccnl_buf_s *bufCleanUpList;
+static CCNL_THREADLOCAL struct ccnl_buf_s *bufCleanUpList;
 
 void
 ccnl_core_addToCleanup(struct ccnl_buf_s *buf)
@@ -901,20 +1887,28 @@ ccnl_core_addToCleanup(struct ccnl_buf_s *buf)
 void
 ccnl_core_cleanup(struct ccnl_relay_s *ccnl)
 {
+    struct ccnl_timerq_s *prevq;
     int k;
     DEBUGMSG(TRACE, "ccnl_core_cleanup %p\n", (void *) ccnl);
 
+    prevq = ccnl_timerq_select(ccnl->timerq);
+
     while (ccnl->pit)
         ccnl_interest_remove(ccnl, ccnl->pit);
+    ccnl_hashtab_cleanup(&ccnl->pitidx);
     while (ccnl->faces)
         ccnl_face_remove(ccnl, ccnl->faces); // also removes all FWD entries
+    ccnl_hashtab_cleanup(&ccnl->faceidx);
+    ccnl_hashtab_cleanup(&ccnl->fibidx);
     while (ccnl->contents)
         ccnl_content_remove(ccnl, ccnl->contents);
-    while (ccnl->nonces) {
-        struct ccnl_buf_s *tmp = ccnl->nonces->next;
-        ccnl_free(ccnl->nonces);
-        ccnl->nonces = tmp;
-    }
+    ccnl_cache_cleanup(ccnl);
+    ccnl_hashtab_cleanup(&ccnl->csidx);
+    ccnl_hashtab_cleanup(&ccnl->csmdidx);
+    ccnl_free(ccnl->nonces.ring);
+    ccnl_free(ccnl->nonces.bucket);
+    ccnl->nonces.ring = NULL;
+    ccnl->nonces.bucket = NULL;
     for (k = 0; k < ccnl->ifcount; k++)
         ccnl_interface_cleanup(ccnl->ifs + k);
 
@@ -927,6 +1921,11 @@ ccnl_core_cleanup(struct ccnl_relay_s *ccnl)
 #ifdef USE_NFN
     ccnl_nfn_freeKrivine(ccnl);
 #endif
+
+    // all timers of the relay are gone now, and so is its own queue
+    (void) ccnl_timerq_select(prevq);
+    ccnl_timerq_free(ccnl->timerq);
+    ccnl->timerq = NULL;
 }
 
 #include "ccnl-core-util.c"
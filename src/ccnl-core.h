@@ -33,8 +33,9 @@
 
 #define CCNL_FACE_FLAGS_STATIC  1
 #define CCNL_FACE_FLAGS_REFLECT 2
-#define CCNL_FACE_FLAGS_SERVED  4
 #define CCNL_FACE_FLAGS_FWDALLI 8 // forward all interests, also known ones
+#define CCNL_FACE_FLAGS_IFWAIT  16 // waits for room in its interface's queue
+#define CCNL_FACE_FLAGS_SNAPSHOT 32 // static while in the workers' FIB snapshot
 
 #define CCNL_FRAG_NONE          0
 #define CCNL_FRAG_SEQUENCED2012 1
@@ -42,6 +43,7 @@
 
 #define CCNL_CONTENT_FLAGS_STATIC  0x01
 #define CCNL_CONTENT_FLAGS_STALE   0x02
+#define CCNL_CONTENT_FLAGS_MD      0x04 // md[] holds the implicit digest
 
 // ----------------------------------------------------------------------
 
@@ -61,8 +63,24 @@ struct ccnl_txrequest_s {
     sockunion dst;
     void (*txdone)(void*, int, int);
     struct ccnl_face_s* txdone_face;
+    double enqueued;            // CCNL_NOW() when put into the queue
 };
 
+struct ccnl_hashlink_s { // embedded in every object that is hash indexed
+    struct ccnl_hashlink_s *next;
+    unsigned int hash;
+    void *obj;                 // NULL if not linked
+};
+
+struct ccnl_hashtab_s { // chained hash table, buckets allocated on demand
+    struct ccnl_hashlink_s **bucket;
+    unsigned int size;         // number of buckets (power of two)
+    unsigned int cnt;          // number of linked objects
+};
+
+// FNV-1a: start with ccnl_hash_init(seed), continue with ccnl_hash_bytes()
+#define ccnl_hash_init(SEED)    (2166136261u ^ (unsigned char) (SEED))
+
 struct ccnl_if_s { // interface for packet IO
     sockunion addr;
 #ifdef CCNL_LINUXKERNEL
@@ -79,23 +97,69 @@ struct ccnl_if_s { // interface for packet IO
     int mtu;
 
     int qlen;  // number of pending sends
+    char txbusy; // the device takes no more for now, see ccnl_interface_enqueue
     int qfront; // index of next packet to send
-    struct ccnl_txrequest_s queue[CCNL_MAX_IF_QLEN];
+    int qmax;   // ring size, 0: CCNL_MAX_IF_QLEN (see ccnl_interface_setqlen)
+    struct ccnl_txrequest_s *queue;
+    int qwait;  // faces waiting for a free slot (CCNL_FACE_FLAGS_IFWAIT)
+    struct ccnl_face_s *qwaithead, *qwaittail; // ... served in this order
+    int qpeak;  // highest number of pending sends so far
+    unsigned long txcnt, drops; // sent, and dropped for lack of queue space
+    double sojourn, sojournmax; // total and longest time in the queue (sec)
     struct ccnl_sched_s *sched;
+#ifdef USE_IOBATCH
+    // how many datagrams each recvmmsg()/sendmmsg() moved, log2 buckets
+    unsigned long rxbatch[CCNL_IO_HISTLEN], txbatch[CCNL_IO_HISTLEN];
+#endif
+};
+
+struct ccnl_nonce_s {
+    int next;                   // next entry in the same bucket, or -1
+    unsigned int hash;          // of the full nonce
+    int len;
+    unsigned char data[CCNL_MAX_NONCE_LEN];
+};
+
+// fixed size set of nonces, the oldest entry is replaced when full
+struct ccnl_nonceset_s {
+    struct ccnl_nonce_s *ring;
+    int *bucket;                // first entry of each bucket, or -1
+    int mask;                   // number of buckets - 1
+    int max, cnt;               // capacity of and entries in the ring
+    int head;                   // next slot to fill
 };
 
 struct ccnl_relay_s {
     time_t startup_time;
     int id;
+    struct ccnl_timerq_s *timerq; // own event queue, NULL: thread default
     struct ccnl_face_s *faces;
+    int lastfaceid;             // the faceid given out last
+    struct ccnl_hashtab_s faceidx; // faces, indexed by peer address
     struct ccnl_forward_s *fib;
+    struct ccnl_hashtab_s fibidx;  // FIB entries, indexed by suite and prefix
+    int fibgen;                 // counts the changes of the FIB
     struct ccnl_interest_s *pit;
-    struct ccnl_content_s *contents; //, *contentsend;
-    struct ccnl_buf_s *nonces;
+    struct ccnl_hashtab_s pitidx;  // PIT entries, indexed by suite and name
+    int pitmdcnt;               // PIT entries whose name may end in a digest
+    unsigned int serveepoch;    // counts the calls of serve_pending()
+    struct ccnl_content_s *contents;
+    struct ccnl_cachestate_s *cachestate; // replacement policy and its data
+    struct ccnl_hashtab_s csidx;   // cached content, indexed by suite and name
+    struct ccnl_hashtab_s csmdidx; // the same, by name + implicit digest
+    struct ccnl_csnode_s *cstrie[CCNL_SUITE_LAST]; // cached content, ordered
+    struct ccnl_nonceset_s nonces; // recently seen nonces
+    int max_nonces;             // 0: CCNL_MAX_NONCES
     int contentcnt;             // number of cached items
     int max_cache_entries;      // -1: unlimited
+    long contentbytes;          // memory used by cached items
+    long contentbytes_peak;     // high-water mark of contentbytes
+    long max_cache_bytes;       // 0: unlimited
     struct ccnl_if_s ifs[CCNL_MAX_INTERFACES];
     int ifcount;                // number of active interfaces
+#ifdef USE_IOBATCH
+    struct ccnl_iobatch_s *iobatch; // datagram batches, see ccnl_io_batches()
+#endif
     char halt_flag;
     struct ccnl_sched_s* (*defaultFaceScheduler)(struct ccnl_relay_s*,
                                                  void(*cts_done)(void*,void*));
@@ -114,6 +178,8 @@ struct ccnl_relay_s {
 struct ccnl_buf_s {
     struct ccnl_buf_s *next;
     unsigned int datalen;
+    int refcnt;     // see ccnl_buf_ref(): a shared buf must not be changed
+    unsigned int fp;    // fingerprint of data[], 0: unknown (ccnl_buf_fp())
     unsigned char data[1];
 };
 
@@ -126,6 +192,9 @@ struct ccnl_prefix_s {
     unsigned int   namelen; // valid length of name memory
     unsigned char *bytes;   // memory for name component copies
     unsigned int *chunknum; // -1 to disable
+    unsigned int *comphash; // cumulative hashes, see ccnl_prefix_comphash()
+    int hashcnt;            // number of valid comphash[] entries
+    char compact;           // arrays follow the struct, see ccnl_prefix_alloc()
 #ifdef USE_NFN
     unsigned int nfnflags;
 # define CCNL_PREFIX_NFN   0x01
@@ -160,9 +229,16 @@ struct ccnl_face_s {
     int faceid;
     int ifndx;
     sockunion peer;
+    struct ccnl_hashlink_s facelink; // entry in relay->faceidx
     int flags;
-    int last_used; // updated when we receive a packet
-    struct ccnl_buf_s *outq, *outqend; // queue of packets to send
+    double last_used; // updated when we receive a packet
+    void *timer;   // ageing
+    unsigned int servedepoch; // see ccnl_content_serve_pending()
+    struct ccnl_buf_s **outq;  // ring of packets to send (references)
+    int outqfront, outqlen, outqmax;
+    struct ccnl_buf_s **outqset; // the same bufs, see ccnl_face_fpfind()
+    struct ccnl_face_s *qwaitnext, *qwaitprev; // see ccnl_interface_wait()
+    int ifqcnt;    // its packets in interface queues (txdone_face)
     struct ccnl_frag_s *frag;  // which special datagram armoring
     struct ccnl_sched_s *sched;
 };
@@ -170,6 +246,7 @@ struct ccnl_face_s {
 struct ccnl_forward_s {
     struct ccnl_forward_s *next;
     struct ccnl_prefix_s *prefix;
+    struct ccnl_hashlink_s fiblink; // entry in relay->fibidx
     struct ccnl_face_s *face;
     char suite;
 };
@@ -190,6 +267,7 @@ struct ccnl_ndntlv_id_s { // interest details
 
 #define CCNL_PIT_COREPROPAGATES    0x01
 #define CCNL_PIT_TRACED            0x02
+#define CCNL_PIT_MAYDIGEST         0x04 // counted in relay->pitmdcnt
 
 struct ccnl_interest_s {
     struct ccnl_buf_s *pkt; // full datagram
@@ -197,9 +275,12 @@ struct ccnl_interest_s {
     struct ccnl_face_s *from;
     struct ccnl_pendint_s *pending; // linked list of faces wanting that content
     struct ccnl_prefix_s *prefix;
+    struct ccnl_hashlink_s pitlink; // entry in relay->pitidx
     int flags;
-    int last_used;
+    double last_used;
     int retries;
+    int lifetime;   // msec, from the packet (0: CCNL_INTEREST_TIMEOUT)
+    void *timer;    // retransmission and ageing
     union {
         struct ccnl_ccnb_id_s ccnb;
         struct ccnl_ccntlv_id_s ccntlv;
@@ -211,7 +292,7 @@ struct ccnl_interest_s {
 struct ccnl_pendint_s { // pending interest
     struct ccnl_pendint_s *next; // , *prev;
     struct ccnl_face_s *face;
-    int last_used;
+    double last_used;
 };
 
 struct ccnl_ccnb_cd_s { // content details
@@ -230,14 +311,27 @@ struct ccnl_content_s {
     struct ccnl_buf_s *pkt; // full datagram
     struct ccnl_content_s *next, *prev;
     struct ccnl_prefix_s *name;
+    struct ccnl_hashlink_s cslink; // entry in relay->csidx
+    struct ccnl_hashlink_s mdlink; // entry in relay->csmdidx, if md known
+    struct ccnl_csnode_s *csnode;  // node in relay->cstrie, if any
+    struct ccnl_content_s *csnodenext;
+    struct ccnl_content_s *cslnext, *cslprev; // in a replacement policy list
+    unsigned char cslist;       // which policy list (0: none)
+    unsigned char freq;         // use count, for LFU
     struct ccnl_buf_s *ppkd; // publisher public key digest
     int flags;
     unsigned char *content; // pointer into the data buffer
     int contentlen;
-    // NON-CONFORM: "The [ContentSTore] MUST also implement the Staleness Bit."
-    // >> CCNL: currently no stale bit, old content is fully removed <<
-    int last_used;
+    // CONFORM: "The [ContentSTore] MUST also implement the Staleness Bit."
+    // >> CCNL_CONTENT_FLAGS_STALE is set when the freshness period is over,
+    //    stale content only answers interests without MustBeFresh <<
+    int freshness;              // msec, from the packet (-1: never stale)
+    double fresh_until;         // CCNL_NOW() when it becomes stale
+    double last_used;
+    void *timer;                // ageing
     int served_cnt;
+    int size;                   // bytes accounted in relay->contentbytes
+    unsigned char md[32];       // see ccnl_content_digest()
     union {
         struct ccnl_ccnb_cd_s ccnb;
         struct ccnl_ccntlv_cd_s ccntlv;
@@ -246,6 +340,15 @@ struct ccnl_content_s {
     char suite;
 };
 
+struct ccnl_csnode_s { // content store trie, one node per name component
+    struct ccnl_csnode_s *parent;
+    struct ccnl_csnode_s **child;  // sorted in canonical order
+    int childcnt, childmax;
+    struct ccnl_content_s *contents; // content with exactly this name
+    int complen;
+    unsigned char comp[];
+};
+
 struct ccnl_lambdaTerm_s {
     char *v;
     struct ccnl_lambdaTerm_s *m, *n;
@@ -39,15 +39,27 @@
 #define CCNL_CONTENT_TIMEOUT            30 // sec
 #define CCNL_INTEREST_TIMEOUT           4  // sec
 #define CCNL_MAX_INTEREST_RETRANSMIT    2
+#define CCNL_INTEREST_RETRANSMIT_TIME   1  // sec
+#define CCNL_TIMER_MAXSEC               2000 // longest timer (usec in an int)
 
 // #define CCNL_FACE_TIMEOUT    60 // sec
 #define CCNL_FACE_TIMEOUT       15 // sec
 
 #define CCNL_MAX_NAME_COMP      64
-#define CCNL_MAX_IF_QLEN        64
+#define CCNL_MAX_IF_QLEN        64  // default size of an interface's queue
+#define CCNL_MAX_FACE_QLEN      1024 // packets a face holds back (power of 2)
+#define CCNL_IO_BATCH           64  // datagrams per interface and IO round
+#define CCNL_IO_HISTLEN         8   // log2 buckets of the batch sizes
 
 #define CCNL_DEFAULT_MAX_CACHE_ENTRIES  0   // means: no content caching
-#define CCNL_MAX_NONCES                 256 // for detected dups
+#define CCNL_MAX_NONCES                 4096 // for detected dups
+#define CCNL_MAX_NONCE_LEN              8   // nonce bytes kept, the rest is hashed
+
+#define CCNL_HASHTAB_MINSIZE            64  // initial number of buckets
+
+#define CCNL_CACHE_LISTS                16  // lists per replacement policy
+#define CCNL_CACHE_SKETCHROWS           4   // W-TinyLFU frequency sketch
+#define CCNL_CACHE_SKETCHMIN            1024 // counters per row, at least
 
 
 enum {
@@ -447,7 +447,7 @@ ccnl_mgmt_crypto(struct ccnl_relay_s *ccnl, char *type, unsigned char *buf, int
           struct ccnl_content_s *c = 0;
           struct ccnl_buf_s *nonce=0, *ppkd=0, *pkt = 0;
           unsigned char *content = 0;
-          char *ht = (char *) ccnl_malloc(sizeof(char)*20);
+          char ht[32];
           int contlen;
           pkt = ccnl_ccnb_extract(&out, &len1, 0, 0, 0, 0,
                                   &prefix_a, &nonce, &ppkd, &content, &contlen);
@@ -460,14 +460,10 @@ ccnl_mgmt_crypto(struct ccnl_relay_s *ccnl, char *type, unsigned char *buf, int
               //ccnl_free(prefix_a);
           }
           //prefix_a = (struct ccnl_prefix_s *)ccnl_malloc(sizeof(struct ccnl_prefix_s));
-          prefix_a->compcnt = 2;
-          prefix_a->comp = (unsigned char **) ccnl_malloc(sizeof(unsigned char*)*2);
-          prefix_a->comp[0] = "mgmt";
-          sprintf(ht, "seqnum-%d", -seqnum);
-          prefix_a->comp[1] = ht;
-          prefix_a->complen = (int *) ccnl_malloc(sizeof(int)*2);
-          prefix_a->complen[0] = strlen("mgmt");
-          prefix_a->complen[1] = strlen(ht);
+          // cached under a name of its own (with fresh hashes)
+          free_prefix(prefix_a);
+          sprintf(ht, "/mgmt/seqnum-%d", -seqnum);
+          prefix_a = ccnl_URItoPrefix(ht, CCNL_SUITE_CCNB, NULL, NULL);
           c = ccnl_content_new(ccnl, CCNL_SUITE_CCNB, &pkt, &prefix_a, &ppkd,
                                 content, contlen);
           if (!c) goto Done;
@@ -166,6 +166,14 @@ ccnl_dump(int lev, int typ, void *p)
 #endif
             if (top->ifs[k].reflect)
                 fprintf(stderr, " reflect=%d", top->ifs[k].reflect);
+            fprintf(stderr, " qlen=%d/%d peak=%d wait=%d sent=%lu drops=%lu"
+                    " sojourn=%.6f/%.6f",
+                    top->ifs[k].qlen, top->ifs[k].qmax ?
+                    top->ifs[k].qmax : CCNL_MAX_IF_QLEN, top->ifs[k].qpeak,
+                    top->ifs[k].qwait, top->ifs[k].txcnt, top->ifs[k].drops,
+                    top->ifs[k].txcnt ?
+                    top->ifs[k].sojourn / top->ifs[k].txcnt : 0.0,
+                    top->ifs[k].sojournmax);
             fprintf(stderr, "\n");
         }
         if (top->faces) {
@@ -180,6 +188,9 @@ ccnl_dump(int lev, int typ, void *p)
         if (top->contents) {
             INDENT(lev); fprintf(stderr, "contents:\n"); ccnl_dump(lev+1, CCNL_CONTENT, top->contents);
         }
+#ifdef USE_MEMPOOL
+        INDENT(lev); fprintf(stderr, "mempools:\n");    ccnl_mempool_dump(lev+1);
+#endif
         break;
     case CCNL_FACE:
         while (fac) {
@@ -200,9 +211,11 @@ ccnl_dump(int lev, int typ, void *p)
             if (fac->frag)
                 ccnl_dump(lev+2, CCNL_FRAG, fac->frag);
             fprintf(stderr, "\n");
-            if (fac->outq) {
+            if (fac->outqlen) {
                 INDENT(lev+1); fprintf(stderr, "outq:\n");
-                ccnl_dump(lev+2, CCNL_BUF, fac->outq);
+                for (i = 0; i < fac->outqlen; i++)
+                    ccnl_dump(lev+2, CCNL_BUF,
+                              fac->outq[(fac->outqfront + i) % fac->outqmax]);
             }
             fac = fac->next;
         }
@@ -244,7 +257,7 @@ ccnl_dump(int lev, int typ, void *p)
                 break;
             }
             INDENT(lev);
-            fprintf(stderr, "%p INTEREST next=%p prev=%p last=%d min=%d max=%d retries=%d\n",
+            fprintf(stderr, "%p INTEREST next=%p prev=%p last=%.3f min=%d max=%d retries=%d\n",
                    (void *) itr, (void *) itr->next, (void *) itr->prev,
                     itr->last_used, mi, ma, itr->retries);
             ccnl_dump(lev+1, CCNL_BUF, itr->pkt);
@@ -266,7 +279,7 @@ ccnl_dump(int lev, int typ, void *p)
     case CCNL_PENDINT:
         while (pir) {
             INDENT(lev);
-            fprintf(stderr, "%p PENDINT next=%p face=%p last=%d\n",
+            fprintf(stderr, "%p PENDINT next=%p face=%p last=%.3f\n",
                    (void *) pir, (void *) pir->next,
                    (void *) pir->face, pir->last_used);
             pir = pir->next;
@@ -275,7 +288,7 @@ ccnl_dump(int lev, int typ, void *p)
     case CCNL_CONTENT:
         while (con) {
             INDENT(lev);
-            fprintf(stderr, "%p CONTENT  next=%p prev=%p last_used=%d served_cnt=%d\n",
+            fprintf(stderr, "%p CONTENT  next=%p prev=%p last_used=%.3f served_cnt=%d\n",
                    (void *) con, (void *) con->next, (void *) con->prev,
                    con->last_used, con->served_cnt);
             ccnl_dump(lev+1, CCNL_PREFIX, con->name);
@@ -484,7 +497,7 @@ get_interest_dump(int lev, void *p, long *interest, long *next, long *prev,
         interest[line] = (long)(void *) itr;
         next[line] = (long)(void *) itr->next;
         prev[line] = (long)(void *) itr->prev;
-        last[line] = itr->last_used;
+        last[line] = (int) itr->last_used;
         retries[line] = itr->retries;
         switch (itr->suite) {
         case CCNL_SUITE_CCNB:
@@ -520,7 +533,7 @@ get_pendint_dump(int lev, void *p, char **out){
     while (pir) {
         INDENT(lev);
         pos = 0;
-        pos += sprintf(out[line] + pos, "%p PENDINT next=%p face=%p last=%d",
+        pos += sprintf(out[line] + pos, "%p PENDINT next=%p face=%p last=%.3f",
                (void *) pir, (void *) pir->next,
                (void *) pir->face, pir->last_used);
         pir = pir->next;
@@ -556,7 +569,7 @@ get_content_dump(int lev, void *p, long *content, long *next, long *prev,
         content[line] = (long)(void *) con;
         next[line] = (long)(void *) con->next;
         prev[line] = (long)(void *) con->prev;
-        last_use[line] = con->last_used;
+        last_use[line] = (int) con->last_used;
         served_cnt[line] = con->served_cnt;
         
         get_prefix_dump(lev, con->name, &prefixlen[line], &prefix[line]);
@@ -582,10 +595,23 @@ char* timestamp(void);
 #  define ccnl_free(p)          debug_free(p, __FILE__, __LINE__)
 #  define ccnl_buf_new(p,s)     debug_buf_new(p, s, __FILE__, __LINE__,timestamp())
 
-void*
-debug_malloc(int s, const char *fn, int lno, char *tstamp)
+#ifdef USE_MEMPOOL // the tracked blocks come from the pools
+#  define ccnl_calloc_type(k,s) debug_calloc_type(k, s, __FILE__, __LINE__,timestamp())
+#  define debug_rawalloc(k,s)   ccnl_mempool_alloc(k,s)
+#  define debug_rawrealloc(p,s) ccnl_mempool_realloc(p,s)
+#  define debug_rawfree(p)      ccnl_mempool_free(p)
+#else
+#  define ccnl_calloc_type(k,s) debug_calloc(1, s, __FILE__, __LINE__,timestamp())
+#  define debug_rawalloc(k,s)   malloc(s)
+#  define debug_rawrealloc(p,s) realloc(p,s)
+#  define debug_rawfree(p)      free(p)
+#endif
+
+// k is the memory pool to use (-1: any)
+static void*
+debug_alloc(int k, int s, const char *fn, int lno, char *tstamp)
 {
-    struct mhdr *h = (struct mhdr *) malloc(s + sizeof(struct mhdr));
+    struct mhdr *h = (struct mhdr *) debug_rawalloc(k, s + sizeof(struct mhdr));
     if (!h) return NULL;
     h->next = mem;
     mem = h;
@@ -601,6 +627,21 @@ debug_malloc(int s, const char *fn, int lno, char *tstamp)
     return ((unsigned char *)h) + sizeof(struct mhdr);
 }
 
+void*
+debug_malloc(int s, const char *fn, int lno, char *tstamp)
+{
+    return debug_alloc(-1, s, fn, lno, tstamp);
+}
+
+void*
+debug_calloc_type(int k, int s, const char *fn, int lno, char *tstamp)
+{
+    void *p = debug_alloc(k, s, fn, lno, tstamp);
+    if (p)
+        memset(p, 0, s);
+    return p;
+}
+
 void*
 debug_calloc(int n, int s, const char *fn, int lno, char *tstamp)
 {
@@ -639,11 +680,11 @@ debug_realloc(void *p, int s, const char *fn, int lno)
                     timestamp(), h->fname, h->lineno, fn, lno);
             return NULL;
         }
-        h = (struct mhdr *) realloc(h, s+sizeof(struct mhdr));
+        h = (struct mhdr *) debug_rawrealloc(h, s+sizeof(struct mhdr));
         if (!h)
             return NULL;
     } else
-        h = (struct mhdr *) malloc(s+sizeof(struct mhdr));
+        h = (struct mhdr *) debug_rawalloc(-1, s+sizeof(struct mhdr));
     h->fname = (char *) fn;
     h->lineno = lno;
     h->size = s;
@@ -683,7 +724,7 @@ debug_free(void *p, const char *fn, int lno)
     }
     if (h->tstamp && *h->tstamp)
         free(h->tstamp);
-    free(h);
+    debug_rawfree(h);
 }
 
 struct ccnl_buf_s*
@@ -696,6 +737,8 @@ debug_buf_new(void *data, int len, const char *fn, int lno, char *tstamp)
         return NULL;
     b->next = NULL;
     b->datalen = len;
+    b->refcnt = 1;
+    b->fp = 0;
     if (data)
         memcpy(b->data, data, len);
     return b;
@@ -704,7 +747,17 @@ debug_buf_new(void *data, int len, const char *fn, int lno, char *tstamp)
 
 #else // !USE_DEBUG_MALLOC
 
-# ifndef CCNL_LINUXKERNEL
+# if defined(USE_MEMPOOL)
+#  define ccnl_calloc_type(k,s) ccnl_mempool_calloctype(k,s)
+#  define ccnl_malloc(s)        ccnl_mempool_malloc(s)
+#  define ccnl_calloc(n,s)      ccnl_mempool_calloc(n,s)
+#  define ccnl_realloc(p,s)     ccnl_mempool_realloc(p,s)
+#  define ccnl_strdup(s)        ccnl_mempool_strdup(s)
+#  define ccnl_free(p)          ccnl_mempool_free(p)
+# else
+#  define ccnl_calloc_type(k,s) ccnl_calloc(1,s)
+# endif
+# if !defined(USE_MEMPOOL) && !defined(CCNL_LINUXKERNEL)
 #  define ccnl_malloc(s)        malloc(s)
 #  define ccnl_calloc(n,s)      calloc(n,s)
 #  define ccnl_realloc(p,s)     realloc(p,s)
@@ -721,6 +774,8 @@ ccnl_buf_new(void *data, int len)
         return NULL;
     b->next = NULL;
     b->datalen = len;
+    b->refcnt = 1;
+    b->fp = 0;
     if (data)
         memcpy(b->data, data, len);
     return b;
@@ -728,16 +783,39 @@ ccnl_buf_new(void *data, int len)
 
 #endif // !USE_DEBUG_MALLOC
 
+// Packets are passed around by reference: the PIT, the content store and
+// every face or interface queue holding the same buf each own one
+// reference, and the last ccnl_buf_release() frees it. A buf that has
+// been shared (or handed to ccnl_face_enqueue()) must not be modified.
+
+struct ccnl_buf_s*
+ccnl_buf_ref(struct ccnl_buf_s *buf)
+{
+    if (buf)
+        buf->refcnt++;
+    return buf;
+}
+
+void
+ccnl_buf_release(struct ccnl_buf_s *buf)
+{
+    if (buf && --buf->refcnt <= 0)
+        ccnl_free(buf);
+}
+
 
 #define free_2ptr_list(a,b)       ccnl_free(a), ccnl_free(b)
 #define free_3ptr_list(a,b,c)     ccnl_free(a), ccnl_free(b), ccnl_free(c)
 #define free_4ptr_list(a,b,c,d)   ccnl_free(a), ccnl_free(b), ccnl_free(c), ccnl_free(d);
 #define free_5ptr_list(a,b,c,d,e) ccnl_free(a), ccnl_free(b), ccnl_free(c), ccnl_free(d), ccnl_free(e);
 
-#define free_prefix(p)  do{ if(p) \
-                free_4ptr_list(p->bytes,p->comp,p->complen,p); } while(0)
+// a compact prefix is one allocation, see ccnl_prefix_alloc()
+#define free_prefix(p)  do{ if(p) { \
+                if (!(p)->compact) \
+                    free_3ptr_list(p->bytes,p->comp,p->complen); \
+                free_2ptr_list(p->chunknum,p); } } while(0)
 #define free_content(c) do{ free_prefix(c->name); \
-                        free_2ptr_list(c->pkt, c); } while(0)
+                        ccnl_buf_release(c->pkt); ccnl_free(c); } while(0)
 
 // -----------------------------------------------------------------
 int debug_level;
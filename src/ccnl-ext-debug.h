@@ -25,12 +25,16 @@
 
 #ifdef USE_DEBUG
 #ifdef USE_DEBUG_MALLOC
+#ifndef CCNL_THREADLOCAL // the utilities do not include ccnl-os-includes.h
+#  define CCNL_THREADLOCAL
+#endif
 struct mhdr {
     struct mhdr *next;
     char *fname;
     int lineno, size;
     char *tstamp;
-} *mem;
+};
+CCNL_THREADLOCAL struct mhdr *mem; // blocks allocated by this thread
 #endif
 
 
@@ -26,6 +26,11 @@ struct ccnl_http_s {
     int server, client; // socket
     unsigned char in[512], *out; // ring buffers
     int inoffs, outoffs, inlen, outlen;
+    char status[64000];         // the page built by ccnl_http_status()
+#ifdef USE_EPOLL
+    int epsock;                 // registered with the relay's epoll set
+    unsigned int epevents;
+#endif
 };
 
 int ccnl_http_status(struct ccnl_relay_s *ccnl, struct ccnl_http_s *http);
@@ -102,16 +107,18 @@ ccnl_http_anteselect(struct ccnl_relay_s *ccnl, struct ccnl_http_s *http,
 }
 
 
-int
-ccnl_http_postselect(struct ccnl_relay_s *ccnl, struct ccnl_http_s *http,
-                     fd_set *readfs, fd_set *writefs)
+// serves the socket which is active: the server socket while there is
+// no client (we accept only one client at the time), else the client
+static void
+ccnl_http_io(struct ccnl_relay_s *ccnl, struct ccnl_http_s *http,
+             int readable, int writable)
 {
-    if (!http)
-        return -1;
-    // accept only one client at the time:
-    if (!http->client && FD_ISSET(http->server, readfs)) {
+    if (!http->client) {
         struct sockaddr_in peer;
         socklen_t len = sizeof(peer);
+
+        if (!readable)
+            return;
         http->client = accept(http->server, (struct sockaddr*) &peer, &len);
         if (http->client < 0)
             http->client = 0;
@@ -119,8 +126,9 @@ ccnl_http_postselect(struct ccnl_relay_s *ccnl, struct ccnl_http_s *http,
             DEBUGMSG(INFO, "accepted web server client\n");
             http->inlen = http->outlen = http->inoffs = http->outoffs = 0;
         }
+        return;
     }
-    if (http->client && FD_ISSET(http->client, readfs)) {
+    if (readable) {
         int len = sizeof(http->in) - http->inlen - 1;
         len = recv(http->client, http->in + http->inlen, len, 0);
         if (len == 0) {
@@ -132,7 +140,7 @@ ccnl_http_postselect(struct ccnl_relay_s *ccnl, struct ccnl_http_s *http,
             ccnl_http_status(ccnl, http);
         }
     }
-    if (http->client && FD_ISSET(http->client, writefs) && http->out) {
+    if (http->client && writable && http->out) {
         int len = send(http->client, http->out + http->outoffs,
                        http->outlen, 0);
         if (len > 0) {
@@ -144,9 +152,75 @@ ccnl_http_postselect(struct ccnl_relay_s *ccnl, struct ccnl_http_s *http,
             }
         }
     }
+}
+
+int
+ccnl_http_postselect(struct ccnl_relay_s *ccnl, struct ccnl_http_s *http,
+                     fd_set *readfs, fd_set *writefs)
+{
+    if (!http)
+        return -1;
+    if (!http->client)
+        ccnl_http_io(ccnl, http, FD_ISSET(http->server, readfs), 0);
+    else
+        ccnl_http_io(ccnl, http, FD_ISSET(http->client, readfs),
+                     FD_ISSET(http->client, writefs));
+    return 0;
+}
+
+#ifdef USE_EPOLL
+
+// brings the epoll set in line with what anteselect() would ask for,
+// ev.data.ptr is the http struct
+int
+ccnl_http_epollctl(struct ccnl_http_s *http, int epfd)
+{
+    struct epoll_event ev;
+    int s;
+
+    if (!http)
+        return -1;
+    memset(&ev, 0, sizeof(ev));
+    if (!http->client) {
+        s = http->server;
+        ev.events = EPOLLIN;
+    } else {
+        s = http->client;
+        if (http->inlen < (int) sizeof(http->in))
+            ev.events |= EPOLLIN;
+        if (http->outlen > 0)
+            ev.events |= EPOLLOUT;
+    }
+    if (s == http->epsock && ev.events == http->epevents)
+        return 0;
+    ev.data.ptr = http;
+    // a closed client socket has already left the set by itself
+    if (http->epsock && http->epsock != s)
+        epoll_ctl(epfd, EPOLL_CTL_DEL, http->epsock, NULL);
+    if (epoll_ctl(epfd, EPOLL_CTL_MOD, s, &ev) < 0 &&
+        epoll_ctl(epfd, EPOLL_CTL_ADD, s, &ev) < 0) {
+        DEBUGMSG(WARNING, "epoll_ctl (http): %s\n", strerror(errno));
+        http->epsock = 0;
+        return -1;
+    }
+    http->epsock = s;
+    http->epevents = ev.events;
     return 0;
 }
 
+int
+ccnl_http_epollevent(struct ccnl_relay_s *ccnl, struct ccnl_http_s *http,
+                     unsigned int events)
+{
+    if (!http)
+        return -1;
+    ccnl_http_io(ccnl, http, events & (EPOLLIN | EPOLLHUP | EPOLLERR),
+                 events & EPOLLOUT);
+    return 0;
+}
+
+#endif // USE_EPOLL
+
 int
 ccnl_cmpfaceid(const void *a, const void *b)
 {
@@ -185,18 +259,16 @@ ccnl_cmpfib(const void *a, const void *b)
 int
 ccnl_http_status(struct ccnl_relay_s *ccnl, struct ccnl_http_s *http)
 {
-    static char txt[64000];
-    char *hdr =
+    char *txt = http->status, *hdr =
         "HTTP/1.1 200 OK\n\r"
         "Content-Type: text/html; charset=utf-8\n\r"
         "Connection: close\n\r\n\r", *cp;
-    int len = strlen(hdr), i, j, cnt;
+    int len = strlen(hdr), i, cnt;
     time_t t;
     struct utsname uts;
     struct ccnl_face_s *f;
     struct ccnl_forward_s *fwd;
     struct ccnl_interest_s *ipt;
-    struct ccnl_buf_s *bpt;
 
     strcpy(txt, hdr);
     len += sprintf(txt+len,
@@ -259,8 +331,7 @@ ccnl_http_status(struct ccnl_relay_s *ccnl, struct ccnl_http_s *http)
             else
                 len += sprintf(txt+len, "%.1fsec",
                         fa[i]->last_used + CCNL_FACE_TIMEOUT - CCNL_NOW());
-            for (j = 0, bpt = fa[i]->outq; bpt; bpt = bpt->next, j++);
-            len += sprintf(txt+len, " &nbsp;qlen=%d\n", j);
+            len += sprintf(txt+len, " &nbsp;qlen=%d\n", fa[i]->outqlen);
         }
         ccnl_free(fa);
     }
@@ -271,20 +342,37 @@ ccnl_http_status(struct ccnl_relay_s *ccnl, struct ccnl_http_s *http)
     for (i = 0; i < ccnl->ifcount; i++) {
         len += sprintf(txt+len, "<li><strong>i%d</strong>&nbsp;&nbsp;"
                        "addr=<font face=courier>%s</font>&nbsp;&nbsp;"
-                       "qlen=%d/%d\n",
+                       "qlen=%d/%d (peak %d)&nbsp;&nbsp;waiting faces=%d\n",
                        i, ccnl_addr2ascii(&ccnl->ifs[i].addr),
-                       ccnl->ifs[i].qlen, CCNL_MAX_IF_QLEN);
+                       ccnl->ifs[i].qlen, ccnl->ifs[i].qmax ?
+                       ccnl->ifs[i].qmax : CCNL_MAX_IF_QLEN,
+                       ccnl->ifs[i].qpeak, ccnl->ifs[i].qwait);
+        len += sprintf(txt+len, "<br>&nbsp;&nbsp;sent=%lu dropped=%lu "
+                       "&nbsp;sojourn avg=%.3fms max=%.3fms\n",
+                       ccnl->ifs[i].txcnt, ccnl->ifs[i].drops,
+                       ccnl->ifs[i].txcnt ? 1000 * ccnl->ifs[i].sojourn /
+                       ccnl->ifs[i].txcnt : 0.0,
+                       1000 * ccnl->ifs[i].sojournmax);
+#ifdef USE_IOBATCH
+        len += sprintf(txt+len, "<br>&nbsp;&nbsp;rx batches: %s\n",
+                       ccnl_iohist2ascii(ccnl->ifs[i].rxbatch));
+        len += sprintf(txt+len, "<br>&nbsp;&nbsp;tx batches: %s\n",
+                       ccnl_iohist2ascii(ccnl->ifs[i].txbatch));
+#endif
     }
     len += sprintf(txt+len, "</ul>\n");
 
     len += sprintf(txt+len, "\n<p><table borders=0 width=100%% bgcolor=#e0e0ff>"
                    "<tr><td><em>Misc stats</em></table><ul>\n");
-    for (cnt = 0, bpt = ccnl->nonces; bpt; bpt = bpt->next, cnt++);
-    len += sprintf(txt+len, "<li>Nonces: %d\n", cnt);
+    len += sprintf(txt+len, "<li>Nonces: %d\n", ccnl->nonces.cnt);
     for (cnt = 0, ipt = ccnl->pit; ipt; ipt = ipt->next, cnt++);
     len += sprintf(txt+len, "<li>Pending interests: %d\n", cnt);
-    len += sprintf(txt+len, "<li>Content chunks: %d (max=%d)\n",
-                   ccnl->contentcnt, ccnl->max_cache_entries);
+    len += sprintf(txt+len, "<li>Content chunks: %d (max=%d, policy=%s)\n",
+                   ccnl->contentcnt, ccnl->max_cache_entries,
+                   ccnl_cache_policyname(ccnl));
+    len += sprintf(txt+len, "<li>Content bytes: %ld (peak=%ld, max=%ld)\n",
+                   ccnl->contentbytes, ccnl->contentbytes_peak,
+                   ccnl->max_cache_bytes);
     len += sprintf(txt+len, "</ul>\n");
 
     len += sprintf(txt+len, "\n<p><table borders=0 width=100%% bgcolor=#e0e0ff>"
@@ -298,7 +386,8 @@ ccnl_http_status(struct ccnl_relay_s *ccnl, struct ccnl_http_s *http)
     len += sprintf(txt+len, "<tr><td>interest.timeout:"
                    "<td align=right> %d<td>\n", CCNL_INTEREST_TIMEOUT);
     len += sprintf(txt+len, "<tr><td>nonces.max:"
-                   "<td align=right> %d<td>\n", CCNL_MAX_NONCES);
+                   "<td align=right> %d<td>\n",
+                   ccnl->max_nonces > 0 ? ccnl->max_nonces : CCNL_MAX_NONCES);
 
     len += sprintf(txt+len, "<tr><td>compile.featureset:<td><td> %s\n",
                    compile_string());
@@ -0,0 +1,324 @@
+/*
+ * @f ccnl-ext-mempool.c
+ * @b CCN lite, pooled memory allocation (size classes and per-type pools)
+ *
+ * Copyright (C) 2026, the CCN-lite contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ * File history:
+ * 2026-10-17 created
+ */
+
+#ifndef CCNL_EXT_MEMPOOL
+#define CCNL_EXT_MEMPOOL
+
+#ifdef USE_MEMPOOL
+
+// With USE_MEMPOOL, ccnl_malloc() and friends (or, with USE_DEBUG_MALLOC,
+// the tracking layer below them) get their memory from here, see
+// ccnl-ext-debug.c. Each pool carves fixed-size blocks out of slabs and
+// keeps freed blocks in a free list: bufs, prefixes, PIT and CS entries
+// are recycled instead of going through the system allocator for every
+// packet. The structures allocated per packet have their own pools
+// (ccnl_calloc_type), everything else is rounded up to the smallest
+// size class that fits, or comes from malloc() if larger than
+// CCNL_MEMPOOL_MAXSIZE. A block remembers its pool, so ccnl_free() works
+// for all of them. Slabs are only given back by ccnl_mempool_cleanup().
+// The pools are per thread, like the relay using them: a block must be
+// freed by the thread which allocated it.
+
+#include "ccnl-ext-debug.h"
+
+#define CCNL_MEMPOOL_ALIGN      8
+#define CCNL_MEMPOOL_MAXSIZE    9216    // larger blocks come from malloc()
+#define CCNL_MEMPOOL_SLABSIZE   16384   // but at least 8 blocks per slab
+#define CCNL_MEMPOOL_MAXPOOLS   32
+#define CCNL_MEMPOOL_PREFIXCOMPS 8      // components of a prefix in its pool
+
+enum { // the per-type pools, followed by the generic size classes
+    CCNL_MEMPOOL_INTEREST,
+    CCNL_MEMPOOL_PENDINT,
+    CCNL_MEMPOOL_CONTENT,
+    CCNL_MEMPOOL_PREFIX,
+    CCNL_MEMPOOL_FACE,
+    CCNL_MEMPOOL_TYPES
+};
+
+#ifdef USE_DEBUG_MALLOC
+#  define CCNL_MEMPOOL_OVERHEAD sizeof(struct mhdr)
+#else
+#  define CCNL_MEMPOOL_OVERHEAD 0
+#endif
+
+// each block (and slab) starts with this header
+union ccnl_memblk_u {
+    union ccnl_memblk_u *next;  // in the free list, or the list of slabs
+    struct {
+        int pool;               // -1: block is from malloc()
+        int size;               // as requested
+    } h;
+    double align;
+};
+
+struct ccnl_mempool_s {
+    char *name;                 // NULL for a generic size class
+    int size;                   // usable bytes per block
+    int perslab;
+    union ccnl_memblk_u *free;
+    union ccnl_memblk_u *slabs;
+    int slabcnt, inuse, peak;
+    long allocs;
+};
+
+static CCNL_THREADLOCAL
+struct ccnl_mempool_s ccnl_mempool[CCNL_MEMPOOL_MAXPOOLS];
+static CCNL_THREADLOCAL int ccnl_mempoolcnt;
+static CCNL_THREADLOCAL int ccnl_mempool_large, ccnl_mempool_largepeak;
+// the size class to use for each request size, in CCNL_MEMPOOL_ALIGN steps
+static CCNL_THREADLOCAL signed char ccnl_mempool_idx[CCNL_MEMPOOL_MAXSIZE/CCNL_MEMPOOL_ALIGN+1];
+
+static void
+ccnl_mempool_add(char *name, int size)
+{
+    struct ccnl_mempool_s *mp = ccnl_mempool + ccnl_mempoolcnt++;
+
+    memset(mp, 0, sizeof(*mp));
+    mp->name = name;
+    mp->size = (size + CCNL_MEMPOOL_ALIGN - 1) & ~(CCNL_MEMPOOL_ALIGN - 1);
+    mp->perslab = CCNL_MEMPOOL_SLABSIZE /
+                  (sizeof(union ccnl_memblk_u) + mp->size);
+    if (mp->perslab < 8)
+        mp->perslab = 8;
+}
+
+static void
+ccnl_mempool_init(void)
+{
+    static int sizes[] = {16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768,
+                          1024, 1536, 2048, 3072, 4096, 6144,
+                          CCNL_MEMPOOL_MAXSIZE};
+    unsigned int i;
+    int k;
+
+    // same order as the CCNL_MEMPOOL_xxx constants
+    ccnl_mempool_add("interest", CCNL_MEMPOOL_OVERHEAD +
+                                 sizeof(struct ccnl_interest_s));
+    ccnl_mempool_add("pendint", CCNL_MEMPOOL_OVERHEAD +
+                                sizeof(struct ccnl_pendint_s));
+    ccnl_mempool_add("content", CCNL_MEMPOOL_OVERHEAD +
+                                sizeof(struct ccnl_content_s));
+    ccnl_mempool_add("prefix", CCNL_MEMPOOL_OVERHEAD + // ccnl_prefix_alloc()
+                               sizeof(struct ccnl_prefix_s) +
+                               CCNL_MEMPOOL_PREFIXCOMPS *
+                               (sizeof(unsigned char*) + 2 * sizeof(int)));
+    ccnl_mempool_add("face", CCNL_MEMPOOL_OVERHEAD +
+                             sizeof(struct ccnl_face_s));
+    for (i = 0; i < sizeof(sizes) / sizeof(int); i++)
+        ccnl_mempool_add(NULL, sizes[i]);
+
+    for (i = 0, k = CCNL_MEMPOOL_TYPES; i < sizeof(ccnl_mempool_idx); i++) {
+        while (ccnl_mempool[k].size < (int) i * CCNL_MEMPOOL_ALIGN)
+            k++;
+        ccnl_mempool_idx[i] = k;
+    }
+}
+
+static int
+ccnl_mempool_grow(struct ccnl_mempool_s *mp)
+{
+    int blksize = sizeof(union ccnl_memblk_u) + mp->size, i;
+    union ccnl_memblk_u *slab, *b;
+
+    slab = (union ccnl_memblk_u*) malloc(sizeof(*slab) +
+                                         mp->perslab * blksize);
+    if (!slab)
+        return -1;
+    slab->next = mp->slabs;
+    mp->slabs = slab;
+    mp->slabcnt++;
+    for (i = mp->perslab - 1; i >= 0; i--) {
+        b = (union ccnl_memblk_u*) ((unsigned char*)(slab + 1) + i * blksize);
+        b->next = mp->free;
+        mp->free = b;
+    }
+    return 0;
+}
+
+// allocates from the given pool, or (k < 0) from the best size class
+void*
+ccnl_mempool_alloc(int k, int size)
+{
+    struct ccnl_mempool_s *mp;
+    union ccnl_memblk_u *b;
+
+    if (!ccnl_mempoolcnt)
+        ccnl_mempool_init();
+    if (k >= 0 && size > ccnl_mempool[k].size)
+        k = -1;
+    if (k < 0 && size > CCNL_MEMPOOL_MAXSIZE) {
+        b = (union ccnl_memblk_u*) malloc(sizeof(*b) + size);
+        if (!b)
+            return NULL;
+        b->h.pool = -1;
+        b->h.size = size;
+        if (++ccnl_mempool_large > ccnl_mempool_largepeak)
+            ccnl_mempool_largepeak = ccnl_mempool_large;
+        return b + 1;
+    }
+    if (k < 0)
+        k = ccnl_mempool_idx[(size + CCNL_MEMPOOL_ALIGN-1) / CCNL_MEMPOOL_ALIGN];
+    mp = ccnl_mempool + k;
+    if (!mp->free && ccnl_mempool_grow(mp))
+        return NULL;
+    b = mp->free;
+    mp->free = b->next;
+    b->h.pool = k;
+    b->h.size = size;
+    if (++mp->inuse > mp->peak)
+        mp->peak = mp->inuse;
+    mp->allocs++;
+    return b + 1;
+}
+
+void*
+ccnl_mempool_malloc(int size)
+{
+    return ccnl_mempool_alloc(-1, size);
+}
+
+void*
+ccnl_mempool_calloc(int n, int size)
+{
+    void *p = ccnl_mempool_alloc(-1, n * size);
+
+    if (p)
+        memset(p, 0, n * size);
+    return p;
+}
+
+void*
+ccnl_mempool_calloctype(int k, int size)
+{
+    void *p = ccnl_mempool_alloc(k, size);
+
+    if (p)
+        memset(p, 0, size);
+    return p;
+}
+
+void
+ccnl_mempool_free(void *p)
+{
+    union ccnl_memblk_u *b;
+    struct ccnl_mempool_s *mp;
+
+    if (!p)
+        return;
+    b = (union ccnl_memblk_u*) p - 1;
+    if (b->h.pool < 0) {
+        ccnl_mempool_large--;
+        free(b);
+        return;
+    }
+    mp = ccnl_mempool + b->h.pool;
+    mp->inuse--;
+    b->next = mp->free;
+    mp->free = b;
+}
+
+void*
+ccnl_mempool_realloc(void *p, int size)
+{
+    union ccnl_memblk_u *b;
+    void *p2;
+
+    if (!p)
+        return ccnl_mempool_malloc(size);
+    b = (union ccnl_memblk_u*) p - 1;
+    if (b->h.pool >= 0 && size <= ccnl_mempool[b->h.pool].size) {
+        b->h.size = size;
+        return p;
+    }
+    if (b->h.pool < 0 && size > CCNL_MEMPOOL_MAXSIZE) {
+        b = (union ccnl_memblk_u*) realloc(b, sizeof(*b) + size);
+        if (!b)
+            return NULL;
+        b->h.size = size;
+        return b + 1;
+    }
+    p2 = ccnl_mempool_malloc(size);
+    if (!p2)
+        return NULL;
+    memcpy(p2, p, b->h.size < size ? b->h.size : size);
+    ccnl_mempool_free(p);
+    return p2;
+}
+
+char*
+ccnl_mempool_strdup(const char *s)
+{
+    char *cp = ccnl_mempool_malloc(strlen(s) + 1);
+
+    if (cp)
+        strcpy(cp, s);
+    return cp;
+}
+
+// gives all slabs back, no pooled block must be used after this
+void
+ccnl_mempool_cleanup(void)
+{
+    union ccnl_memblk_u *slab;
+    int k;
+
+    for (k = 0; k < ccnl_mempoolcnt; k++)
+        while (ccnl_mempool[k].slabs) {
+            slab = ccnl_mempool[k].slabs;
+            ccnl_mempool[k].slabs = slab->next;
+            free(slab);
+        }
+    ccnl_mempoolcnt = 0;
+}
+
+void
+ccnl_mempool_dump(int lev)
+{
+    struct ccnl_mempool_s *mp;
+    int i, k;
+
+    for (k = 0; k < ccnl_mempoolcnt; k++) {
+        mp = ccnl_mempool + k;
+        if (!mp->slabcnt)
+            continue;
+        for (i = 0; i < lev; i++)
+            fprintf(stderr, "  ");
+        if (mp->name)
+            fprintf(stderr, "%-9s", mp->name);
+        else
+            fprintf(stderr, "%-9d", mp->size);
+        fprintf(stderr, " size=%d inuse=%d peak=%d free=%d slabs=%d"
+                " allocs=%ld\n", mp->size, mp->inuse, mp->peak,
+                mp->slabcnt * mp->perslab - mp->inuse, mp->slabcnt,
+                mp->allocs);
+    }
+    for (i = 0; i < lev; i++)
+        fprintf(stderr, "  ");
+    fprintf(stderr, "%-9s inuse=%d peak=%d\n", "large",
+            ccnl_mempool_large, ccnl_mempool_largepeak);
+}
+
+#endif // USE_MEMPOOL
+
+#endif // CCNL_EXT_MEMPOOL
+// eof
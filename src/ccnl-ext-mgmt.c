@@ -99,7 +99,7 @@ ccnl_mgmt_send_return_split(struct ccnl_relay_s *ccnl, struct ccnl_buf_s *orig,
                 struct ccnl_content_s *c = 0;
                 struct ccnl_buf_s *nonce=0, *ppkd=0, *pkt = 0;
                 unsigned char *content = 0;
-                unsigned char *ht = (unsigned char *) ccnl_malloc(sizeof(char)*20);
+                char ht[32];
                 int contlen;
                 pkt = ccnl_ccnb_extract(&buf2, &len5, 0, 0, 0, 0,
                                 &prefix_a, &nonce, &ppkd, &content, &contlen);
@@ -107,14 +107,10 @@ ccnl_mgmt_send_return_split(struct ccnl_relay_s *ccnl, struct ccnl_buf_s *orig,
                 if (!pkt) {
                      DEBUGMSG(WARNING, " parsing error\n"); 
                 }
-                prefix_a->compcnt = 2;
-                prefix_a->comp = (unsigned char **) ccnl_malloc(sizeof(unsigned char*)*2);
-                prefix_a->comp[0] = (unsigned char *)"mgmt";
-                sprintf((char*)ht, "seqnum-%d", it);
-                prefix_a->comp[1] = ht;
-                prefix_a->complen = (int *) ccnl_malloc(sizeof(int)*2);
-                prefix_a->complen[0] = strlen("mgmt");
-                prefix_a->complen[1] = strlen((char*)ht);
+                // cached under a name of its own (with fresh hashes)
+                free_prefix(prefix_a);
+                sprintf(ht, "/mgmt/seqnum-%d", it);
+                prefix_a = ccnl_URItoPrefix(ht, CCNL_SUITE_CCNB, NULL, NULL);
                 c = ccnl_content_new(ccnl, CCNL_SUITE_CCNB, &pkt, &prefix_a,
                                      &ppkd, content, contlen);
                 //if (!c) goto Done;
@@ -139,23 +135,15 @@ ccnl_prefix_clone(struct ccnl_prefix_s *p)
     int i, len;
     struct ccnl_prefix_s *p2;
 
-    p2 = (struct ccnl_prefix_s*) ccnl_calloc(1, sizeof(struct ccnl_prefix_s));
-    if (!p2) return NULL;
     for (i = 0, len = 0; i < p->compcnt; len += p->complen[i++]);
-    p2->bytes = (unsigned char*) ccnl_malloc(len);
-    p2->comp = (unsigned char**) ccnl_malloc(p->compcnt*sizeof(char *));
-    p2->complen = (int*) ccnl_malloc(p->compcnt*sizeof(int));
-    if (!p2->comp || !p2->complen || !p2->bytes) goto Bail;
-    p2->compcnt = p->compcnt;
+    p2 = ccnl_prefix_alloc(0, p->compcnt, len);
+    if (!p2) return NULL;
     for (i = 0, len = 0; i < p->compcnt; len += p2->complen[i++]) {
         p2->complen[i] = p->complen[i];
         p2->comp[i] = p2->bytes + len;
         memcpy(p2->comp[i], p->comp[i], p2->complen[i]);
     }
     return p2;
-Bail:
-    free_prefix(p2);
-    return NULL;
 }
 
 // ----------------------------------------------------------------------
@@ -1397,7 +1385,7 @@ ccnl_mgmt_prefixreg(struct ccnl_relay_s *ccnl, struct ccnl_buf_s *orig,
     // should (re)verify that action=="prefixreg"
     if (faceid && p->compcnt > 0) {
         struct ccnl_face_s *f;
-        struct ccnl_forward_s *fwd, **fwd2;
+        struct ccnl_forward_s *fwd;
         int fi = strtol((const char*)faceid, NULL, 0);
         
         p->suite = suite[0];
@@ -1416,10 +1404,7 @@ ccnl_mgmt_prefixreg(struct ccnl_relay_s *ccnl, struct ccnl_buf_s *orig,
         if (suite)
             fwd->suite = suite[0];
 
-        fwd2 = &ccnl->fib;
-        while (*fwd2)
-            fwd2 = &((*fwd2)->next);
-        *fwd2 = fwd;
+        ccnl_fib_add(ccnl, fwd);
         cp = "prefixreg cmd worked";
     } else {
         DEBUGMSG(TRACE, "mgmt: ignored prefixreg faceid=%s\n", faceid);
@@ -1557,7 +1542,7 @@ ccnl_mgmt_addcacheobject(struct ccnl_relay_s *ccnl, struct ccnl_buf_s *orig,
     
     if(!interest) return 0;
     //Send interest to from!
-    ccnl_face_enqueue(ccnl, from, buf_dup(interest->pkt));
+    ccnl_face_enqueue(ccnl, from, ccnl_buf_ref(interest->pkt));
 
 Bail:
     return 0;   
@@ -68,6 +68,8 @@ ccnl_nfn_query2interest(struct ccnl_relay_s *ccnl,
     from->faceid = config->configid;
     from->last_used = CCNL_NOW();
     from->outq = NULL;
+    from->outqlen = from->outqmax = 0;
+    from->outqset = NULL;
     DEBUGMSG(DEBUG, "  Configuration ID: %d\n", config->configid);
 
     buf = ccnl_mkSimpleInterest(*prefix, &nonce);
@@ -301,53 +303,54 @@ create_prefix_for_content_on_result_stack(struct ccnl_relay_s *ccnl,
 {
     struct ccnl_prefix_s *name;
     int it, len = 0, offset = 0;
+    unsigned char *bytes = ccnl_calloc(1, CCNL_MAX_PACKET_SIZE);
 
-    name = ccnl_prefix_new(config->suite, 2);
-    if (!name)
+    if (!bytes)
         return NULL;
-
 #ifdef USE_SUITE_CCNTLV
     if (config->suite == CCNL_SUITE_CCNTLV)
         offset = 4;
 #endif
-    name->bytes = ccnl_calloc(1, CCNL_MAX_PACKET_SIZE);
-    name->compcnt = 1;
-    //len = ccnl_pkt_mkComponent(config->suite, name->bytes, "NFN", strlen("NFN")); //FIXME: AT THE END?
-    name->complen[1] = len;
-    name->comp[0] = name->bytes + offset + len;
+    //len = ccnl_pkt_mkComponent(config->suite, bytes, "NFN", strlen("NFN")); //FIXME: AT THE END?
 
-    len += sprintf((char *)name->bytes + offset + len, "(call %d",
+    len += sprintf((char *)bytes + offset + len, "(call %d",
                    config->fox_state->num_of_params);
     for (it = 0; it < config->fox_state->num_of_params; ++it) {
         struct stack_s *stack = config->fox_state->params[it];
         if (stack->type == STACK_TYPE_PREFIX) {
             char *pref_str = ccnl_prefix_to_path(
                                       (struct ccnl_prefix_s*)stack->content);
-            len += sprintf((char*)name->bytes + offset + len, " %s", pref_str);
+            len += sprintf((char*)bytes + offset + len, " %s", pref_str);
         } else if (stack->type == STACK_TYPE_INT) {
-            len += sprintf((char*)name->bytes + offset + len, " %d",
+            len += sprintf((char*)bytes + offset + len, " %d",
                            *(int*)stack->content);
 
         } else if (stack->type == STACK_TYPE_CONST) {
             struct const_s *con = stack->content;
             DEBUGMSG(DEBUG, "strlen: %d str: %.*s \n", con->len, con->len+2, ccnl_nfn_krivine_const2str(con));
-            len += sprintf((char*)name->bytes + offset + len, " %.*s", con->len+2, ccnl_nfn_krivine_const2str(con));
+            len += sprintf((char*)bytes + offset + len, " %.*s", con->len+2, ccnl_nfn_krivine_const2str(con));
         } else {
             DEBUGMSG(WARNING, "Invalid stack type %d\n", stack->type);
+            ccnl_free(bytes);
             return NULL;
         }
 
     }
     
-    len += sprintf((char *)name->bytes + offset + len, ")");
+    len += sprintf((char *)bytes + offset + len, ")");
 #ifdef USE_SUITE_CCNTLV
     if (config->suite == CCNL_SUITE_CCNTLV) {
-        ccnl_ccntlv_prependTL(CCNX_TLV_N_NameSegment, len, &offset,
-                              name->bytes + name->complen[1]);
+        ccnl_ccntlv_prependTL(CCNX_TLV_N_NameSegment, len, &offset, bytes);
         len += 4;
     }
 #endif
-    name->complen[0] = len;
+    name = ccnl_prefix_alloc(config->suite, 1, len);
+    if (name) {
+        memcpy(name->bytes, bytes, len);
+        name->comp[0] = name->bytes;
+        name->complen[0] = len;
+    }
+    ccnl_free(bytes);
     return name;
 }
 
@@ -410,7 +413,9 @@ ccnl_nfn_add_thunk(struct ccnl_relay_s *ccnl, struct configuration_s *config,
     
     if (ccnl_nfnprefix_isTHUNK(new_prefix)) {
         new_prefix->comp[new_prefix->compcnt-2] = new_prefix->comp[new_prefix->compcnt-1];
+        new_prefix->complen[new_prefix->compcnt-2] = new_prefix->complen[new_prefix->compcnt-1];
         --new_prefix->compcnt;
+        new_prefix->hashcnt = 0;
     }
 
     thunk = ccnl_calloc(1, sizeof(struct thunk_s));
@@ -514,9 +519,12 @@ ccnl_nack_reply(struct ccnl_relay_s *ccnl, struct ccnl_prefix_s *prefix,
     }
     nack = ccnl_nfn_result2content(ccnl, &prefix,
                                     (unsigned char*)":NACK", 5);
+    if (!nack)
+        return;
     ccnl_nfn_monitor(ccnl, from, nack->name, nack->content, nack->contentlen);
     DEBUGMSG(WARNING, "+++ nack->pkt is %p\n", (void*) nack->pkt);
-    ccnl_face_enqueue(ccnl, from, nack->pkt);
+    ccnl_face_enqueue(ccnl, from, nack->pkt); // the queue takes the pkt
+    ccnl_free(nack); // but nack->name is still the interest's prefix
 }
 #endif // USE_NACK
 
@@ -629,12 +637,16 @@ ccnl_nfnprefix_mkCallPrefix(struct ccnl_prefix_s *name, int thunk_request,
                             struct configuration_s *config, int parameter_num)
 {
     int i, len, offset = 0;
-    struct ccnl_prefix_s *p;
+    struct ccnl_prefix_s *p, *p2;
     char *bytes = ccnl_malloc(CCNL_MAX_PACKET_SIZE);
 
+    // p is built with its components in bytes, then copied
     p = ccnl_prefix_new(name->suite, name->compcnt + 1);
-    if (!p)
+    if (!p || !bytes) {
+        free_prefix(p);
+        ccnl_free(bytes);
         return NULL;
+    }
 
     p->compcnt = name->compcnt + 1;
     p->nfnflags = CCNL_PREFIX_NFN;
@@ -663,26 +675,27 @@ ccnl_nfnprefix_mkCallPrefix(struct ccnl_prefix_s *name, int thunk_request,
         p->complen[i] += 4;
     }
 #endif
-    len += p->complen[i];
 
-    p->bytes = ccnl_realloc(bytes, len);
-    for (i = 0; i < p->compcnt; i++)
-        p->comp[i] = (unsigned char*)(p->bytes + ((char*)p->comp[i] - bytes));
-
-    return p;
+    p2 = ccnl_prefix_dup(p);
+    free_prefix(p);
+    ccnl_free(bytes);
+    return p2;
 }
 
 struct ccnl_prefix_s*
 ccnl_nfnprefix_mkComputePrefix(struct configuration_s *config, int suite)
 {
-    int i, len = 0, offset = 0;
-    struct ccnl_prefix_s *p;
+    int len = 0, offset = 0;
+    struct ccnl_prefix_s *p, *p2;
     char *bytes = ccnl_malloc(CCNL_MAX_PACKET_SIZE);
 
+    // p is built with its components in bytes, then copied
     p = ccnl_prefix_new(suite, 2);
-    p->compcnt = 2;
-    if (!p)
+    if (!p || !bytes) {
+        free_prefix(p);
+        ccnl_free(bytes);
         return NULL;
+    }
     p->nfnflags = CCNL_PREFIX_NFN;
     if (config->fox_state->thunk_request)
         p->nfnflags |= CCNL_PREFIX_THUNK;
@@ -704,13 +717,11 @@ ccnl_nfnprefix_mkComputePrefix(struct configuration_s *config, int suite)
         p->complen[1] += 4;
     }
 #endif
-    len += p->complen[1];
-
-    p->bytes = ccnl_realloc(bytes, len);
-    for (i = 0; i < p->compcnt; i++)
-        p->comp[i] = (unsigned char*)(p->bytes + ((char*)p->comp[i] - bytes));
 
-    return p;
+    p2 = ccnl_prefix_dup(p);
+    free_prefix(p);
+    ccnl_free(bytes);
+    return p2;
 }
 
 // eof
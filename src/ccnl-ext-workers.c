@@ -0,0 +1,452 @@
+/*
+ * @f ccnl-ext-workers.c
+ * @b CCN lite extension: one relay process per core, sharded by name
+ *
+ * Copyright (C) 2026, the CCN-lite contributors
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ * File history:
+ * 2026-10-17 created
+ */
+
+#ifdef USE_WORKERS
+
+// With more than one worker, the relay forks into that many processes
+// (worker 0 is the original one). Each has its own UDP socket bound with
+// SO_REUSEPORT to the same port, so the kernel spreads the peers over
+// the workers, and its own PIT and content store: a name belongs to the
+// shard selected by the hash of its first CCNL_WORKER_SHARDCOMPS
+// components. As an interest matches all data under its name, this must
+// be at most the length of the shortest interest name, hence only the
+// first component (an interest for "/" only sees its own shard). A packet which arrives at the wrong worker is copied into
+// a single-producer/single-consumer ring in shared memory (one ring per
+// pair of workers) and the owner is woken through its eventfd. The owner
+// handles it as if it had received it itself, i.e. it answers from its
+// own socket (same UDP port).
+//
+// Management requests are handled by worker 0 only, the other workers
+// hand them over like packets of another shard. Whenever its FIB
+// changes, worker 0 publishes a snapshot of it in shared memory (guarded
+// by a sequence counter, readers retry until they got a consistent copy)
+// and the other workers replace their FIB by it. The faces a snapshot
+// refers to are static there until a later snapshot no longer has them.
+//
+// Workers are processes and not threads. The event queue, the IO
+// batches, the memory pools and the debug allocator are kept per relay
+// or per thread, but the logging, the signal handling and the NFN
+// machine still assume one relay per process.
+
+#define CCNL_WORKER_MAX         16
+#define CCNL_WORKER_RINGSLOTS   64      // packets per ring
+#define CCNL_WORKER_SHARDCOMPS  1       // name components selecting the shard
+#define CCNL_WORKER_MAXFIB      256     // FIB entries in the snapshot
+#define CCNL_WORKER_FIBCOMPS    16      // components of such an entry ...
+#define CCNL_WORKER_FIBNAMELEN  256     // ... and their bytes
+
+struct ccnl_worker_slot_s {
+    int ifndx, len, addrlen;
+    sockunion peer;
+    unsigned char data[CCNL_MAX_PACKET_SIZE];
+};
+
+struct ccnl_worker_ring_s {
+    unsigned int head;          // written by the producer only
+    char pad1[60];              // (keep head and tail on their own lines)
+    unsigned int tail;          // written by the consumer only
+    char pad2[60];
+    struct ccnl_worker_slot_s slot[CCNL_WORKER_RINGSLOTS];
+};
+
+struct ccnl_worker_fib_s {
+    char suite;
+    int ifndx, addrlen, flags;
+    sockunion peer;
+    int compcnt, complen[CCNL_WORKER_FIBCOMPS];
+    unsigned char name[CCNL_WORKER_FIBNAMELEN]; // components back to back
+};
+
+struct ccnl_worker_shm_s {
+    unsigned int fibgen;        // odd while the snapshot is written
+    int fibcnt;
+    struct ccnl_worker_fib_s fib[CCNL_WORKER_MAXFIB];
+    struct ccnl_worker_ring_s ring[1]; // [from * cnt + to]
+};
+
+struct ccnl_worker_s {
+    int cnt, self;
+    struct ccnl_worker_shm_s *shm;
+    size_t shmsize;
+    int wakefd[CCNL_WORKER_MAX];
+    pid_t pid[CCNL_WORKER_MAX];
+    char wakeup[CCNL_WORKER_MAX]; // handed packets to them in this round
+    unsigned int fibgen;        // of the snapshot written or applied
+    int fibversion;             // worker 0: relay->fibgen when published
+    struct ccnl_relay_s *relay;
+    long handedoff, received, dropped;
+};
+
+struct ccnl_worker_s ccnl_worker = { 1, 0 };
+
+// ----------------------------------------------------------------------
+
+static int
+ccnl_worker_addrlen(sockunion *su)
+{
+    switch (su->sa.sa_family) {
+    case AF_INET:
+        return sizeof(struct sockaddr_in);
+#ifdef USE_ETHERNET
+    case AF_PACKET:
+        return sizeof(struct sockaddr_ll);
+#endif
+#ifdef USE_UNIXSOCKET
+    case AF_UNIX:
+        return sizeof(struct sockaddr_un);
+#endif
+    default:
+        return 0;
+    }
+}
+
+static int
+ccnl_worker_shard(struct ccnl_prefix_s *p)
+{
+    int n = p->compcnt < CCNL_WORKER_SHARDCOMPS ?
+                                        p->compcnt : CCNL_WORKER_SHARDCOMPS;
+
+    return ccnl_prefix_comphash(p, n) % ccnl_worker.cnt;
+}
+
+int
+ccnl_worker_owns(struct ccnl_prefix_s *p)
+{
+    return ccnl_worker.cnt <= 1 || ccnl_worker_shard(p) == ccnl_worker.self;
+}
+
+// hands a packet (an interest or content object) to the worker owning its
+// name, returns 1 if this worker must not process it any further
+int
+ccnl_worker_steer(struct ccnl_relay_s *relay, struct ccnl_face_s *from,
+                  int suite, struct ccnl_prefix_s *p, struct ccnl_buf_s *buf)
+{
+    struct ccnl_worker_ring_s *r;
+    struct ccnl_worker_slot_s *s;
+    unsigned int head;
+    int w;
+
+    if (ccnl_worker.cnt <= 1 || !from || from->ifndx < 0 || !p || !buf)
+        return 0;
+    w = ccnl_worker_shard(p);
+#ifdef USE_SUITE_CCNB
+    if (suite == CCNL_SUITE_CCNB && p->compcnt == 4 &&
+                                        !memcmp(p->comp[0], "ccnx", 4))
+        w = 0; // mgmt request, see ccnl_ccnb_fwd()
+#endif
+    if (w == ccnl_worker.self)
+        return 0;
+
+    r = ccnl_worker.shm->ring + ccnl_worker.self * ccnl_worker.cnt + w;
+    head = r->head;
+    if (head - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) >=
+                                        CCNL_WORKER_RINGSLOTS ||
+                                        buf->datalen > sizeof(s->data)) {
+        DEBUGMSG(DEBUG, "  worker %d: ring full, dropped\n", w);
+        ccnl_worker.dropped++;
+        return 1;
+    }
+    s = r->slot + head % CCNL_WORKER_RINGSLOTS;
+    s->ifndx = from->ifndx;
+    s->addrlen = ccnl_worker_addrlen(&from->peer);
+    memcpy(&s->peer, &from->peer, s->addrlen);
+    s->len = buf->datalen;
+    memcpy(s->data, buf->data, buf->datalen);
+#ifdef USE_SUITE_CCNTLV
+    if (suite == CCNL_SUITE_CCNTLV) // the owner decrements it again
+        ((struct ccnx_tlvhdr_ccnx201412_s*) s->data)->hoplimit++;
+#endif
+    __atomic_store_n(&r->head, head + 1, __ATOMIC_RELEASE);
+    ccnl_worker.wakeup[w] = 1;
+    ccnl_worker.handedoff++;
+    DEBUGMSG(DEBUG, "  handed to worker %d\n", w);
+
+    return 1;
+}
+
+// processes what the other workers handed to us
+void
+ccnl_worker_RX(struct ccnl_relay_s *relay)
+{
+    struct ccnl_worker_ring_s *r;
+    struct ccnl_worker_slot_s *s;
+    unsigned int tail;
+    uint64_t cnt;
+    int w;
+
+    if (read(ccnl_worker.wakefd[ccnl_worker.self], &cnt, sizeof(cnt)) < 0)
+        cnt = 0; // nothing, or somebody else reset it
+    for (w = 0; w < ccnl_worker.cnt; w++) {
+        if (w == ccnl_worker.self)
+            continue;
+        r = ccnl_worker.shm->ring + w * ccnl_worker.cnt + ccnl_worker.self;
+        for (tail = r->tail;
+             tail != __atomic_load_n(&r->head, __ATOMIC_ACQUIRE); tail++) {
+            s = r->slot + tail % CCNL_WORKER_RINGSLOTS;
+            if (s->ifndx < relay->ifcount)
+                ccnl_core_RX(relay, s->ifndx, s->data, s->len,
+                             &s->peer.sa, s->addrlen);
+            __atomic_store_n(&r->tail, tail + 1, __ATOMIC_RELEASE);
+            ccnl_worker.received++;
+        }
+    }
+}
+
+int
+ccnl_worker_wakefd(void)
+{
+    return ccnl_worker.cnt > 1 ? ccnl_worker.wakefd[ccnl_worker.self] : -1;
+}
+
+static void
+ccnl_worker_wake(int w)
+{
+    uint64_t one = 1;
+
+    if (write(ccnl_worker.wakefd[w], &one, sizeof(one)) < 0)
+        DEBUGMSG(WARNING, "worker %d: wakeup failed (%s)\n",
+                 w, strerror(errno));
+}
+
+// ----------------------------------------------------------------------
+// the FIB snapshot
+
+static void
+ccnl_worker_fibpublish(struct ccnl_relay_s *relay)
+{
+    struct ccnl_worker_shm_s *shm = ccnl_worker.shm;
+    struct ccnl_worker_fib_s *e;
+    struct ccnl_forward_s *fwd;
+    int i, len, n = 0;
+
+    __atomic_store_n(&shm->fibgen, ccnl_worker.fibgen + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    for (fwd = relay->fib; fwd; fwd = fwd->next) {
+        if (!fwd->face || fwd->face->ifndx < 0 ||
+                              fwd->prefix->compcnt > CCNL_WORKER_FIBCOMPS)
+            continue;
+        for (i = len = 0; i < fwd->prefix->compcnt; i++)
+            len += fwd->prefix->complen[i];
+        if (len > CCNL_WORKER_FIBNAMELEN || n >= CCNL_WORKER_MAXFIB) {
+            DEBUGMSG(WARNING, "FIB entry %s not passed to the workers\n",
+                     ccnl_prefix_to_path(fwd->prefix));
+            continue;
+        }
+        e = shm->fib + n++;
+        e->suite = fwd->suite;
+        e->ifndx = fwd->face->ifndx;
+        e->flags = fwd->face->flags;
+        e->addrlen = ccnl_worker_addrlen(&fwd->face->peer);
+        memcpy(&e->peer, &fwd->face->peer, sizeof(sockunion));
+        e->compcnt = fwd->prefix->compcnt;
+        for (i = len = 0; i < e->compcnt; i++) {
+            e->complen[i] = fwd->prefix->complen[i];
+            memcpy(e->name + len, fwd->prefix->comp[i], e->complen[i]);
+            len += e->complen[i];
+        }
+    }
+    shm->fibcnt = n;
+    ccnl_worker.fibversion = relay->fibgen;
+    ccnl_worker.fibgen += 2;
+    __atomic_store_n(&shm->fibgen, ccnl_worker.fibgen, __ATOMIC_RELEASE);
+
+    for (i = 1; i < ccnl_worker.cnt; i++)
+        ccnl_worker_wake(i);
+}
+
+static void
+ccnl_worker_fibapply(struct ccnl_relay_s *relay)
+{
+    static struct ccnl_worker_fib_s fib[CCNL_WORKER_MAXFIB];
+    struct ccnl_worker_shm_s *shm = ccnl_worker.shm;
+    struct ccnl_worker_fib_s *e;
+    struct ccnl_forward_s *fwd;
+    struct ccnl_prefix_s *p;
+    struct ccnl_face_s *f;
+    unsigned int gen;
+    int i, k, len, n;
+
+    gen = __atomic_load_n(&shm->fibgen, __ATOMIC_ACQUIRE);
+    if (gen == ccnl_worker.fibgen || (gen & 1))
+        return;
+    n = shm->fibcnt;
+    memcpy(fib, shm->fib, n * sizeof(*fib));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&shm->fibgen, __ATOMIC_RELAXED) != gen)
+        return; // changed while copying, try again in the next round
+    ccnl_worker.fibgen = gen;
+
+    while ((fwd = relay->fib)) {
+        relay->fib = fwd->next;
+        ccnl_hashtab_remove(&relay->fibidx, &fwd->fiblink);
+        free_prefix(fwd->prefix);
+        ccnl_free(fwd);
+    }
+    // the faces of the previous snapshot age again, unless listed below
+    for (f = relay->faces; f; f = f->next)
+        if (f->flags & CCNL_FACE_FLAGS_SNAPSHOT)
+            f->flags &= ~(CCNL_FACE_FLAGS_SNAPSHOT | CCNL_FACE_FLAGS_STATIC);
+    for (i = 0, e = fib; i < n; i++, e++) {
+        if (e->ifndx >= relay->ifcount)
+            continue;
+        f = ccnl_get_face_or_create(relay, e->ifndx, &e->peer.sa, e->addrlen);
+        if (!f)
+            continue;
+        // it goes away with the snapshot entry, not by ageing
+        if (!(f->flags & CCNL_FACE_FLAGS_STATIC))
+            f->flags |= CCNL_FACE_FLAGS_SNAPSHOT | CCNL_FACE_FLAGS_STATIC;
+        f->flags |= e->flags & (CCNL_FACE_FLAGS_REFLECT |
+                                CCNL_FACE_FLAGS_FWDALLI);
+        for (k = len = 0; k < e->compcnt; k++)
+            len += e->complen[k];
+        p = ccnl_prefix_alloc(e->suite, e->compcnt, len);
+        fwd = (struct ccnl_forward_s *) ccnl_calloc(1, sizeof(*fwd));
+        if (!p || !fwd) {
+            free_prefix(p);
+            ccnl_free(fwd);
+            continue;
+        }
+        for (k = len = 0; k < e->compcnt; k++) {
+            p->comp[k] = p->bytes + len;
+            p->complen[k] = e->complen[k];
+            memcpy(p->comp[k], e->name + len, e->complen[k]);
+            len += e->complen[k];
+        }
+        p->compcnt = e->compcnt;
+        ccnl_prefix_comphash(p, p->compcnt);
+        fwd->prefix = p;
+        fwd->face = f;
+        fwd->suite = e->suite;
+        ccnl_fib_add(relay, fwd);
+    }
+    DEBUGMSG(INFO, "worker %d: FIB snapshot with %d entries\n",
+             ccnl_worker.self, n);
+}
+
+// once per round of the IO loop, before it waits
+void
+ccnl_worker_poll(struct ccnl_relay_s *relay)
+{
+    int w;
+
+    if (ccnl_worker.cnt <= 1)
+        return;
+    for (w = 0; w < ccnl_worker.cnt; w++)
+        if (ccnl_worker.wakeup[w]) {
+            ccnl_worker.wakeup[w] = 0;
+            ccnl_worker_wake(w);
+        }
+    if (ccnl_worker.self == 0) {
+        if (relay->fibgen != ccnl_worker.fibversion)
+            ccnl_worker_fibpublish(relay);
+    } else
+        ccnl_worker_fibapply(relay);
+}
+
+// ----------------------------------------------------------------------
+
+static void
+ccnl_worker_sigterm(int sig)
+{
+    if (ccnl_worker.relay)
+        ccnl_worker.relay->halt_flag = 1;
+}
+
+// forks cnt-1 more workers, returns (in each of them) the worker's number
+int
+ccnl_worker_start(struct ccnl_relay_s *relay, int cnt)
+{
+    struct sigaction sa;
+    int w;
+
+    if (cnt <= 1)
+        return 0;
+    if (cnt > CCNL_WORKER_MAX) {
+        DEBUGMSG(WARNING, "at most %d workers\n", CCNL_WORKER_MAX);
+        cnt = CCNL_WORKER_MAX;
+    }
+    ccnl_worker.shmsize = sizeof(struct ccnl_worker_shm_s) +
+                        (cnt * cnt - 1) * sizeof(struct ccnl_worker_ring_s);
+    ccnl_worker.shm = mmap(NULL, ccnl_worker.shmsize, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (ccnl_worker.shm == MAP_FAILED) {
+        perror("mmap");
+        return -1;
+    }
+    for (w = 0; w < cnt; w++) {
+        ccnl_worker.wakefd[w] = eventfd(0, EFD_NONBLOCK);
+        if (ccnl_worker.wakefd[w] < 0) {
+            perror("eventfd");
+            return -1;
+        }
+    }
+    ccnl_worker.cnt = cnt;
+    ccnl_worker.relay = relay;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = ccnl_worker_sigterm;
+    sigaction(SIGTERM, &sa, NULL);
+
+    ccnl_worker.pid[0] = getpid();
+    for (w = 1; w < cnt; w++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            ccnl_worker.cnt = w; // not all shards are served ...
+            return -1;
+        }
+        if (pid == 0) {
+            ccnl_worker.self = w;
+            prctl(PR_SET_PDEATHSIG, SIGTERM);
+            break;
+        }
+        ccnl_worker.pid[w] = pid;
+    }
+    DEBUGMSG(INFO, "worker %d of %d (pid %d)\n",
+             ccnl_worker.self, cnt, (int) getpid());
+
+    return ccnl_worker.self;
+}
+
+// worker 0 waits for the others
+void
+ccnl_worker_stop(void)
+{
+    int w;
+
+    if (ccnl_worker.cnt <= 1)
+        return;
+    DEBUGMSG(INFO, "worker %d: %ld packets handed off, %ld received, "
+             "%ld dropped\n", ccnl_worker.self, ccnl_worker.handedoff,
+             ccnl_worker.received, ccnl_worker.dropped);
+    if (ccnl_worker.self != 0)
+        return;
+    for (w = 1; w < ccnl_worker.cnt; w++)
+        kill(ccnl_worker.pid[w], SIGTERM);
+    for (w = 1; w < ccnl_worker.cnt; w++)
+        waitpid(ccnl_worker.pid[w], NULL, 0);
+    munmap(ccnl_worker.shm, ccnl_worker.shmsize);
+}
+
+#endif // USE_WORKERS
+
+// eof
@@ -175,6 +175,20 @@ int ccnl_mgmt(struct ccnl_relay_s *ccnl, struct ccnl_buf_s *buf,
 
 // ----------------------------------------------------------------------
 
+#ifdef USE_WORKERS
+
+int ccnl_worker_owns(struct ccnl_prefix_s *p);
+int ccnl_worker_steer(struct ccnl_relay_s *relay, struct ccnl_face_s *from,
+                      int suite, struct ccnl_prefix_s *p,
+                      struct ccnl_buf_s *buf);
+
+#else
+# define ccnl_worker_owns(p)            1
+# define ccnl_worker_steer(r,f,s,p,b)   0
+#endif
+
+// ----------------------------------------------------------------------
+
 #ifdef USE_SCHEDULER
 
 void ccnl_sched_RTS(struct ccnl_sched_s *s, int cnt, int len,
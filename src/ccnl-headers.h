@@ -18,10 +18,22 @@ struct rdr_ds_s *ds;
 
 /* ccnl-core.c */
 int ccnl_prefix_cmp(struct ccnl_prefix_s *name, unsigned char *md, struct ccnl_prefix_s *p, int mode);
+unsigned int ccnl_hash_bytes(unsigned int h, unsigned char *data, int len);
+unsigned int ccnl_hash_comp(unsigned int h, unsigned char *comp, int len);
+unsigned int ccnl_prefix_comphash(struct ccnl_prefix_s *p, int n);
+unsigned int ccnl_prefix_hash(int suite, struct ccnl_prefix_s *p, int n);
+unsigned int ccnl_prefix_hash_md(int suite, struct ccnl_prefix_s *p, unsigned char *md);
+void ccnl_hashtab_add(struct ccnl_hashtab_s *t, struct ccnl_hashlink_s *l, unsigned int hash, void *obj);
+void ccnl_hashtab_remove(struct ccnl_hashtab_s *t, struct ccnl_hashlink_s *l);
+struct ccnl_hashlink_s *ccnl_hashtab_next(struct ccnl_hashlink_s *l);
+struct ccnl_hashlink_s *ccnl_hashtab_first(struct ccnl_hashtab_s *t, unsigned int hash);
+void ccnl_hashtab_cleanup(struct ccnl_hashtab_s *t);
 int ccnl_addr_cmp(sockunion *s1, sockunion *s2);
+unsigned int ccnl_addr_hash(sockunion *su);
 struct ccnl_face_s *ccnl_get_face_or_create(struct ccnl_relay_s *ccnl, int ifndx, struct sockaddr *sa, int addrlen);
 struct ccnl_face_s *ccnl_face_remove(struct ccnl_relay_s *ccnl, struct ccnl_face_s *f);
 void ccnl_interface_cleanup(struct ccnl_if_s *i);
+int ccnl_interface_setqlen(struct ccnl_if_s *ifc, int qmax);
 void ccnl_interface_CTS(void *aux1, void *aux2);
 void ccnl_interface_enqueue(void (tx_done)(void *, int, int), struct ccnl_face_s *f, struct ccnl_relay_s *ccnl, struct ccnl_if_s *ifc, struct ccnl_buf_s *buf, sockunion *dest);
 struct ccnl_buf_s *ccnl_face_dequeue(struct ccnl_relay_s *ccnl, struct ccnl_face_s *f);
@@ -29,15 +41,32 @@ void ccnl_face_CTS_done(void *ptr, int cnt, int len);
 void ccnl_face_CTS(struct ccnl_relay_s *ccnl, struct ccnl_face_s *f);
 int ccnl_face_enqueue(struct ccnl_relay_s *ccnl, struct ccnl_face_s *to, struct ccnl_buf_s *buf);
 struct ccnl_interest_s *ccnl_interest_new(struct ccnl_relay_s *ccnl, struct ccnl_face_s *from, char suite, struct ccnl_buf_s **pkt, struct ccnl_prefix_s **prefix, int minsuffix, int maxsuffix);
+void ccnl_interest_setlifetime(struct ccnl_relay_s *ccnl, struct ccnl_interest_s *i, int lifetime);
+void ccnl_interest_extendlifetime(struct ccnl_interest_s *i, int lifetime);
+void ccnl_fib_add(struct ccnl_relay_s *ccnl, struct ccnl_forward_s *fwd);
+void ccnl_cstrie_add(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c);
+void ccnl_cstrie_remove(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c);
+struct ccnl_content_s *ccnl_cstrie_lookup(struct ccnl_relay_s *ccnl, int suite, struct ccnl_prefix_s *p, int minsfx, int maxsfx, int mbf, struct ccnl_buf_s *ppk);
+struct ccnl_content_s *ccnl_cs_find(struct ccnl_relay_s *ccnl, struct ccnl_content_s *after, char suite, struct ccnl_prefix_s *p);
+struct ccnl_content_s *ccnl_cs_findpkt(struct ccnl_relay_s *ccnl, char suite, struct ccnl_prefix_s *p, struct ccnl_buf_s *pkt);
+struct ccnl_interest_s *ccnl_pit_find(struct ccnl_relay_s *ccnl, struct ccnl_interest_s *after, char suite, struct ccnl_prefix_s *p);
 int ccnl_interest_append_pending(struct ccnl_interest_s *i, struct ccnl_face_s *from);
-void ccnl_interest_propagate(struct ccnl_relay_s *ccnl, struct ccnl_interest_s *i);
+int ccnl_interest_propagate(struct ccnl_relay_s *ccnl, struct ccnl_interest_s *i);
 struct ccnl_interest_s *ccnl_interest_remove(struct ccnl_relay_s *ccnl, struct ccnl_interest_s *i);
 int ccnl_i_prefixof_c(struct ccnl_prefix_s *prefix, int minsuffix, int maxsuffix, struct ccnl_content_s *c);
+unsigned char *ccnl_content_digest(struct ccnl_content_s *c);
 struct ccnl_content_s *ccnl_content_new(struct ccnl_relay_s *ccnl, char suite, struct ccnl_buf_s **pkt, struct ccnl_prefix_s **prefix, struct ccnl_buf_s **ppk, unsigned char *content, int contlen);
+void ccnl_content_used(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c);
+int ccnl_cache_setpolicy(struct ccnl_relay_s *ccnl, char *name);
+char *ccnl_cache_policyname(struct ccnl_relay_s *ccnl);
+void ccnl_cache_cleanup(struct ccnl_relay_s *ccnl);
 struct ccnl_content_s *ccnl_content_remove(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c);
 struct ccnl_content_s *ccnl_content_add2cache(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c);
+void ccnl_content_refresh(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c);
 int ccnl_content_serve_pending(struct ccnl_relay_s *ccnl, struct ccnl_content_s *c);
-void ccnl_do_ageing(void *ptr, void *dummy);
+void ccnl_face_ageing(void *relay, void *aux);
+void ccnl_interest_ageing(void *relay, void *aux);
+void ccnl_content_ageing(void *relay, void *aux);
 int ccnl_nonce_find_or_append(struct ccnl_relay_s *ccnl, struct ccnl_buf_s *nonce);
 void ccnl_core_RX(struct ccnl_relay_s *relay, int ifndx, unsigned char *data, int datalen, struct sockaddr *sa, int addrlen);
 void ccnl_core_init(void);
@@ -49,6 +78,9 @@ void ccnl_core_cleanup(struct ccnl_relay_s *ccnl);
 /* ccnl-ext-debug.c */
 const char *compile_string(void);
 //struct ccnl_buf_s *ccnl_buf_new(void *data, int len);
+struct ccnl_buf_s *ccnl_buf_ref(struct ccnl_buf_s *buf);
+unsigned int ccnl_buf_fp(struct ccnl_buf_s *buf);
+void ccnl_buf_release(struct ccnl_buf_s *buf);
 
 #ifdef USE_DEBUG
 char *eth2ascii(unsigned char *eth);
@@ -72,6 +104,7 @@ int get_content_dump(int lev, void *p, long *content, long *next, long *prev, in
 #ifdef USE_DEBUG_MALLOC
 void *debug_malloc(int s, const char *fn, int lno, char *tstamp);
 void *debug_calloc(int n, int s, const char *fn, int lno, char *tstamp);
+void *debug_calloc_type(int k, int s, const char *fn, int lno, char *tstamp);
 int debug_unlink(struct mhdr *hdr);
 void *debug_realloc(void *p, int s, const char *fn, int lno);
 void *debug_strdup(const char *s, const char *fn, int lno, char *tstamp);
@@ -79,6 +112,21 @@ void debug_free(void *p, const char *fn, int lno);
 #endif
 
 
+//---------------------------------------------------------------------------------------------------------------------------------------
+/* ccnl-ext-mempool.c */
+#ifdef USE_MEMPOOL
+void *ccnl_mempool_alloc(int k, int size);
+void *ccnl_mempool_malloc(int size);
+void *ccnl_mempool_calloc(int n, int size);
+void *ccnl_mempool_calloctype(int k, int size);
+void ccnl_mempool_free(void *p);
+void *ccnl_mempool_realloc(void *p, int size);
+char *ccnl_mempool_strdup(const char *s);
+void ccnl_mempool_cleanup(void);
+void ccnl_mempool_dump(int lev);
+#endif
+
+
 //---------------------------------------------------------------------------------------------------------------------------------------
 /* ccnl-ext-frag.c */
 #ifdef USE_FRAG
@@ -103,6 +151,10 @@ struct ccnl_http_s *ccnl_http_cleanup(struct ccnl_http_s *http);
 int ccnl_cmpfaceid(const void *a, const void *b);
 int ccnl_cmpfib(const void *a, const void *b);
 int ccnl_http_status(struct ccnl_relay_s *ccnl, struct ccnl_http_s *http);
+#ifdef USE_EPOLL
+int ccnl_http_epollctl(struct ccnl_http_s *http, int epfd);
+int ccnl_http_epollevent(struct ccnl_relay_s *ccnl, struct ccnl_http_s *http, unsigned int events);
+#endif
 #endif
 
 
@@ -193,6 +245,8 @@ long timevaldelta(struct timeval *a, struct timeval *b);
 int current_time(void);
 #else 
 double current_time(void);
+double ccnl_clock_precise(void);
+void ccnl_clock_tick(void);
 #endif
 char *timestamp(void);
 #if defined(CCNL_UNIX) || defined(CCNL_SIMULATION)
@@ -200,6 +254,12 @@ void ccnl_get_timeval(struct timeval *tv);
 void *ccnl_set_timer(int usec, void (*fct)(void *aux1, void *aux2), void *aux1, void *aux2);
 void *ccnl_set_absolute_timer(struct timeval abstime, void (*fct)(void *aux1, void *aux2), void *aux1, void *aux2);
 void ccnl_rem_timer(void *h);
+struct ccnl_timer_s *ccnl_timer_first(void);
+void ccnl_timer_fire(struct ccnl_timer_s *t);
+void ccnl_timer_cleanup(void);
+struct ccnl_timerq_s *ccnl_timerq_select(struct ccnl_timerq_s *q);
+struct ccnl_timerq_s *ccnl_timerq_new(void);
+void ccnl_timerq_free(struct ccnl_timerq_s *q);
 #endif
 
 
@@ -226,10 +286,15 @@ int unescape_component(char *comp);
 int ccnl_URItoComponents(char **compVector, unsigned int *compLens, char *uri);
 struct ccnl_prefix_s *ccnl_URItoPrefix(char *uri, int suite, char *nfnexpr, unsigned int *chunknum);
 int ccnl_pkt_mkComponent(int suite, unsigned char *dst, char *src, int srclen);
+struct ccnl_prefix_s *ccnl_prefix_alloc(int suite, int cnt, int len);
+struct ccnl_prefix_s *ccnl_prefix_pack(struct ccnl_prefix_s *tmp);
 struct ccnl_prefix_s *ccnl_prefix_dup(struct ccnl_prefix_s *prefix);
 int ccnl_pkt2suite(unsigned char *data, int len, int *skip);
 char *ccnl_prefix_to_path(struct ccnl_prefix_s *pr);
 char* ccnl_prefix_to_path_detailed(struct ccnl_prefix_s *pr, int ccntlv_skip, int escape_components, int call_slash);
+#ifdef USE_IOBATCH
+char *ccnl_iohist2ascii(unsigned long *hist);
+#endif
 char *ccnl_lambdaParseVar(char **cpp);
 struct ccnl_lambdaTerm_s *ccnl_lambdaStrToTerm(int lev, char **cp, int (*prt)(char *fmt, ...));
 int ccnl_lambdaTermToStr(char *cfg, struct ccnl_lambdaTerm_s *t, char last);
@@ -309,7 +374,7 @@ int ccnl_ndntlv_forwarder(struct ccnl_relay_s *relay, struct ccnl_face_s *from,
 const char *compile_string(void);
 unsigned long int ccnl_ndntlv_nonNegInt(unsigned char *cp, int len);
 int ccnl_ndntlv_dehead(unsigned char **buf, int *len, int *typ, int *vallen);
-struct ccnl_buf_s *ccnl_ndntlv_extract(int hdrlen, unsigned char **data, int *datalen, int *scope, int *mbf, int *min, int *max, unsigned int *final_block_id, struct ccnl_prefix_s **prefix, struct ccnl_prefix_s **tracing, struct ccnl_buf_s **nonce, struct ccnl_buf_s **ppkl, unsigned char **content, int *contlen);
+struct ccnl_buf_s *ccnl_ndntlv_extract(int hdrlen, unsigned char **data, int *datalen, int *scope, int *mbf, int *min, int *max, int *lifetime, int *freshness, unsigned int *final_block_id, struct ccnl_prefix_s **prefix, struct ccnl_prefix_s **tracing, struct ccnl_buf_s **nonce, struct ccnl_buf_s **ppkl, unsigned char **content, int *contlen);
 int ccnl_ndntlv_prependTLval(unsigned long val, int *offset, unsigned char *buf);
 int ccnl_ndntlv_prependTL(int type, unsigned int len, int *offset, unsigned char *buf);
 int ccnl_ndntlv_prependNonNegInt(int type, unsigned int val, int *offset, unsigned char *buf);
@@ -40,7 +40,7 @@
 #include <sys/un.h>
 #include <sys/utsname.h>
 
-#if !(defined(_BSD_SOURCE) || defined(SVID_SOURCE))
+#if !(defined(_BSD_SOURCE) || defined(SVID_SOURCE) || defined(__USE_MISC))
 #  define __USE_MISC
 #endif
 
@@ -56,16 +56,34 @@
 #  include <sys/types.h>
 #  undef USE_ETHERNET
    // ethernet support in FreeBSD is work in progress ...
+#  undef USE_EPOLL
+#  undef USE_IOBATCH
+#  undef USE_WORKERS
 #elif defined(linux)
 #  include <endian.h>
 #  include <linux/if_ether.h>  // ETH_ALEN
 #  include <linux/if_packet.h> // sockaddr_ll
+#  ifdef USE_EPOLL
+#    include <sys/epoll.h>
+#  endif
+#  ifdef USE_WORKERS
+#    include <signal.h>
+#    include <stdint.h>
+#    include <sys/eventfd.h>
+#    include <sys/mman.h>
+#    include <sys/prctl.h>
+#    include <sys/wait.h>
+#  endif
 #endif
 
 #ifdef USE_CCNxDIGEST
 #  include <openssl/sha.h>
 #endif
 
+#ifdef __GNUC__
+#  define CCNL_THREADLOCAL __thread // state which is kept per thread
+#endif
+
 #else // else we are compiling for the Linux kernel
 
 #include <stddef.h>
@@ -103,4 +121,8 @@
 
 #endif // CCNL_LINUXKERNEL
 
+#ifndef CCNL_THREADLOCAL
+#  define CCNL_THREADLOCAL
+#endif
+
 // eof
@@ -125,7 +125,7 @@ ccnl_rem_timer(void *p)
 // for omnet.
 //
 struct ccnl_timer_s {
-    struct ccnl_timer_s *next;
+    struct ccnl_timer_s *next;  // in the list of unused records
     struct timeval timeout;
     void (*fct)(char,int);
     void (*fct2)(void*,void*);
@@ -133,13 +133,63 @@ struct ccnl_timer_s {
     int intarg;
     void *aux1;
     void *aux2;
-    int handler;
+    int handler;                // sequence number, orders equal timeouts
+    int idx;                    // position in the record pool
+    int heappos;                // position in the heap, -1: not scheduled
+    unsigned long gen;          // incremented each time the record is reused
 };
 
 
 #if defined(CCNL_UNIX) || defined(CCNL_SIMULATION)
 
-struct ccnl_timer_s *eventqueue;
+// Pending timers are kept in a binary min-heap ordered by their timeout.
+// The records come from a pool which grows in chunks and is only freed
+// by ccnl_timer_cleanup(). A handle encodes the record's pool index and
+// its generation: removing a timer that has already fired (and whose
+// record may have been reused since) does no harm.
+//
+// Heap and pool form an event queue. The timer functions work on the
+// queue selected for the calling thread, by default a per-thread one.
+// A relay with its own queue (relay->timerq) selects it while it runs,
+// so that several relays can share a process or a thread.
+
+#define CCNL_TIMER_CHUNK        64      // records allocated at a time
+#define CCNL_TIMER_IDXBITS      (sizeof(void*) > 4 ? 32 : 20)
+
+struct ccnl_timerq_s {
+    struct ccnl_timer_s **heap;
+    int cnt, heapmax;
+    struct ccnl_timer_s **chunk;
+    int chunkcnt;
+    struct ccnl_timer_s *free;
+    int handlercnt;
+};
+
+static CCNL_THREADLOCAL struct ccnl_timerq_s ccnl_timerq_default;
+static CCNL_THREADLOCAL struct ccnl_timerq_s *ccnl_timerq;
+
+// makes q (NULL: the thread's default queue) the current event queue,
+// returns the previous one
+struct ccnl_timerq_s*
+ccnl_timerq_select(struct ccnl_timerq_s *q)
+{
+    struct ccnl_timerq_s *prev = ccnl_timerq;
+
+    ccnl_timerq = q;
+    return prev;
+}
+
+struct ccnl_timerq_s*
+ccnl_timerq_new(void)
+{
+    return (struct ccnl_timerq_s*) ccnl_calloc(1, sizeof(struct ccnl_timerq_s));
+}
+
+static struct ccnl_timerq_s*
+ccnl_timerq_cur(void)
+{
+    return ccnl_timerq ? ccnl_timerq : &ccnl_timerq_default;
+}
 
 void
 ccnl_get_timeval(struct timeval *tv)
@@ -147,105 +197,310 @@ ccnl_get_timeval(struct timeval *tv)
     gettimeofday(tv, NULL);
 }
 
-void*
-ccnl_set_timer(int usec, void (*fct)(void *aux1, void *aux2),
-                 void *aux1, void *aux2)
+static int
+ccnl_timer_before(struct ccnl_timer_s *a, struct ccnl_timer_s *b)
 {
-    struct ccnl_timer_s *t, **pp;
-    static int handlercnt;
+    if (a->timeout.tv_sec != b->timeout.tv_sec)
+        return a->timeout.tv_sec < b->timeout.tv_sec;
+    if (a->timeout.tv_usec != b->timeout.tv_usec)
+        return a->timeout.tv_usec < b->timeout.tv_usec;
+    return a->handler - b->handler < 0;
+}
 
-    t = (struct ccnl_timer_s *) ccnl_calloc(1, sizeof(*t));
-    if (!t)
-        return 0;
-    t->fct2 = fct;
-    gettimeofday(&t->timeout, NULL);
-    usec += t->timeout.tv_usec;
-    t->timeout.tv_sec += usec / 1000000;
-    t->timeout.tv_usec = usec % 1000000;
-    t->aux1 = aux1;
-    t->aux2 = aux2;
+static void
+ccnl_timer_heapset(struct ccnl_timerq_s *q, int pos, struct ccnl_timer_s *t)
+{
+    q->heap[pos] = t;
+    t->heappos = pos;
+}
 
-    for (pp = &eventqueue; ; pp = &((*pp)->next)) {
-    if (!*pp || (*pp)->timeout.tv_sec > t->timeout.tv_sec ||
-        ((*pp)->timeout.tv_sec == t->timeout.tv_sec &&
-         (*pp)->timeout.tv_usec > t->timeout.tv_usec)) {
-        t->next = *pp;
-        t->handler = handlercnt++;
-        *pp = t;
-        return t;
+static void
+ccnl_timer_siftup(struct ccnl_timerq_s *q, int pos)
+{
+    struct ccnl_timer_s *t = q->heap[pos];
+
+    while (pos > 0 && ccnl_timer_before(t, q->heap[(pos - 1) / 2])) {
+        ccnl_timer_heapset(q, pos, q->heap[(pos - 1) / 2]);
+        pos = (pos - 1) / 2;
     }
+    ccnl_timer_heapset(q, pos, t);
+}
+
+static void
+ccnl_timer_siftdown(struct ccnl_timerq_s *q, int pos)
+{
+    struct ccnl_timer_s *t = q->heap[pos];
+    int c;
+
+    while ((c = 2 * pos + 1) < q->cnt) {
+        if (c + 1 < q->cnt && ccnl_timer_before(q->heap[c + 1], q->heap[c]))
+            c++;
+        if (!ccnl_timer_before(q->heap[c], t))
+            break;
+        ccnl_timer_heapset(q, pos, q->heap[c]);
+        pos = c;
     }
-    return NULL; // ?
+    ccnl_timer_heapset(q, pos, t);
+}
+
+static void*
+ccnl_timer_handle(struct ccnl_timer_s *t)
+{
+    return (void*) ((t->gen << CCNL_TIMER_IDXBITS) | (t->idx + 1));
+}
+
+static struct ccnl_timer_s*
+ccnl_timer_alloc(struct ccnl_timerq_s *q)
+{
+    struct ccnl_timer_s *t, **tmp;
+    int i;
+
+    if (!q->free) {
+        if ((q->chunkcnt + 1) * CCNL_TIMER_CHUNK >= 1L << CCNL_TIMER_IDXBITS)
+            return NULL;
+        tmp = (struct ccnl_timer_s**) ccnl_malloc((q->chunkcnt + 1) *
+                                                  sizeof(*tmp));
+        if (!tmp)
+            return NULL;
+        if (q->chunkcnt)
+            memcpy(tmp, q->chunk, q->chunkcnt * sizeof(*tmp));
+        t = (struct ccnl_timer_s*) ccnl_calloc(CCNL_TIMER_CHUNK, sizeof(*t));
+        if (!t) {
+            ccnl_free(tmp);
+            return NULL;
+        }
+        ccnl_free(q->chunk);
+        q->chunk = tmp;
+        q->chunk[q->chunkcnt] = t;
+        for (i = CCNL_TIMER_CHUNK - 1; i >= 0; i--) {
+            t[i].idx = q->chunkcnt * CCNL_TIMER_CHUNK + i;
+            t[i].heappos = -1;
+            t[i].next = q->free;
+            q->free = t + i;
+        }
+        q->chunkcnt++;
+    }
+    if (q->cnt == q->heapmax) {
+        int max = q->heapmax ? 2 * q->heapmax : CCNL_TIMER_CHUNK;
+        tmp = (struct ccnl_timer_s**) ccnl_malloc(max * sizeof(*tmp));
+        if (!tmp)
+            return NULL;
+        if (q->cnt)
+            memcpy(tmp, q->heap, q->cnt * sizeof(*tmp));
+        ccnl_free(q->heap);
+        q->heap = tmp;
+        q->heapmax = max;
+    }
+    t = q->free;
+    q->free = t->next;
+    t->next = NULL;
+    return t;
+}
+
+// takes t out of the heap and returns the record to the pool
+static void
+ccnl_timer_release(struct ccnl_timerq_s *q, struct ccnl_timer_s *t)
+{
+    int pos = t->heappos;
+
+    if (pos < 0)
+        return;
+    t->heappos = -1;
+    if (pos != --q->cnt) {
+        ccnl_timer_heapset(q, pos, q->heap[q->cnt]);
+        if (pos > 0 && ccnl_timer_before(q->heap[pos],
+                                         q->heap[(pos - 1) / 2]))
+            ccnl_timer_siftup(q, pos);
+        else
+            ccnl_timer_siftdown(q, pos);
+    }
+    t->gen++;
+    t->fct = NULL;
+    t->fct2 = NULL;
+    t->next = q->free;
+    q->free = t;
 }
 
 void*
 ccnl_set_absolute_timer(struct timeval abstime, void (*fct)(void *aux1, void *aux2),
          void *aux1, void *aux2)
 {
-    struct ccnl_timer_s *t, **pp;
-    static int handlercnt;
+    struct ccnl_timerq_s *q = ccnl_timerq_cur();
+    struct ccnl_timer_s *t;
 
-    t = (struct ccnl_timer_s *) ccnl_calloc(1, sizeof(*t));
+    t = ccnl_timer_alloc(q);
     if (!t)
-    return 0;
+        return 0;
     t->fct2 = fct;
     t->timeout = abstime;
     t->aux1 = aux1;
     t->aux2 = aux2;
+    t->handler = q->handlercnt++;
 
-    for (pp = &eventqueue; ; pp = &((*pp)->next)) {
-    if (!*pp || (*pp)->timeout.tv_sec > t->timeout.tv_sec ||
-        ((*pp)->timeout.tv_sec == t->timeout.tv_sec &&
-         (*pp)->timeout.tv_usec > t->timeout.tv_usec)) {
-        t->next = *pp;
-        t->handler = handlercnt++;
-        *pp = t;
-        return t;
-    }
-    }
-    return NULL; // ?
+    q->cnt++;
+    ccnl_timer_heapset(q, q->cnt - 1, t);
+    ccnl_timer_siftup(q, q->cnt - 1);
+    return ccnl_timer_handle(t);
+}
+
+void*
+ccnl_set_timer(int usec, void (*fct)(void *aux1, void *aux2),
+                 void *aux1, void *aux2)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    usec += tv.tv_usec;
+    tv.tv_sec += usec / 1000000;
+    tv.tv_usec = usec % 1000000;
+    return ccnl_set_absolute_timer(tv, fct, aux1, aux2);
 }
 
 void
 ccnl_rem_timer(void *h)
 {
-    struct ccnl_timer_s **pp;
+    struct ccnl_timerq_s *q = ccnl_timerq_cur();
+    unsigned long idx = (unsigned long) h & ((1L << CCNL_TIMER_IDXBITS) - 1);
+    struct ccnl_timer_s *t;
 
-    for (pp = &eventqueue; *pp; pp = &((*pp)->next)) {
-        if ((void*)*pp == h) {
-            struct ccnl_timer_s *e = *pp;
-            *pp = e->next;
-            ccnl_free(e);
-            break;
-        }
-    }
+    if (!idx || idx > (unsigned long) q->chunkcnt * CCNL_TIMER_CHUNK)
+        return;
+    idx--;
+    t = q->chunk[idx / CCNL_TIMER_CHUNK] + idx % CCNL_TIMER_CHUNK;
+    if (ccnl_timer_handle(t) == h)
+        ccnl_timer_release(q, t);
+}
+
+// the timer to fire next, or NULL
+struct ccnl_timer_s*
+ccnl_timer_first(void)
+{
+    struct ccnl_timerq_s *q = ccnl_timerq_cur();
+
+    return q->cnt ? q->heap[0] : NULL;
+}
+
+// removes t and calls its handler
+void
+ccnl_timer_fire(struct ccnl_timer_s *t)
+{
+    void (*fct)(char,int) = t->fct;
+    void (*fct2)(void*,void*) = t->fct2;
+    char node = t->node;
+    int intarg = t->intarg;
+    void *aux1 = t->aux1, *aux2 = t->aux2;
+
+    ccnl_timer_release(ccnl_timerq_cur(), t);
+    if (fct)
+        (fct)(node, intarg);
+    else if (fct2)
+        (fct2)(aux1, aux2);
+}
+
+static void
+ccnl_timerq_cleanup(struct ccnl_timerq_s *q)
+{
+    int i;
+
+    for (i = 0; i < q->chunkcnt; i++)
+        ccnl_free(q->chunk[i]);
+    ccnl_free(q->chunk);
+    ccnl_free(q->heap);
+    q->chunk = q->heap = NULL;
+    q->free = NULL;
+    q->chunkcnt = q->cnt = q->heapmax = 0;
+}
+
+// drops all pending timers of the current queue and frees its record pool
+void
+ccnl_timer_cleanup(void)
+{
+    ccnl_timerq_cleanup(ccnl_timerq_cur());
+}
+
+void
+ccnl_timerq_free(struct ccnl_timerq_s *q)
+{
+    if (!q)
+        return;
+    if (ccnl_timerq == q)
+        ccnl_timerq = NULL;
+    ccnl_timerq_cleanup(q);
+    ccnl_free(q);
 }
 
 #endif
 
 
-double
-current_time(void)
+// CCNL_NOW() is asked for several times per packet. The relay's event
+// loop calls ccnl_clock_tick() once per round, which samples a coarse
+// monotonic clock, and everything done in that round sees this time.
+// Without the ticks (utilities, tests) CCNL_NOW() reads the precise
+// clock, which is also what ccnl_clock_precise() is for (log stamps,
+// measuring round trips). Both count seconds since the first reading,
+// which ccnl_core_init() takes so that all threads share the origin.
+
+#ifdef CLOCK_MONOTONIC
+#  ifndef CLOCK_MONOTONIC_COARSE
+#    define CLOCK_MONOTONIC_COARSE      CLOCK_MONOTONIC
+#  endif
+#endif
+
+static double ccnl_clock_start = -1;
+static CCNL_THREADLOCAL double ccnl_clock_cached;
+static CCNL_THREADLOCAL int ccnl_clock_ticking;
+
+static double
+ccnl_clock_read(int coarse)
 {
+    double t;
+#ifdef CLOCK_MONOTONIC
+    struct timespec ts;
+
+    clock_gettime(coarse ? CLOCK_MONOTONIC_COARSE : CLOCK_MONOTONIC, &ts);
+    t = ts.tv_sec + ts.tv_nsec / 1000000000.0;
+#else
     struct timeval tv;
-    static time_t start;
-    static time_t start_usec;
 
+    (void) coarse;
     ccnl_get_timeval(&tv);
+    t = tv.tv_sec + tv.tv_usec / 1000000.0;
+#endif
+    if (ccnl_clock_start < 0)
+        ccnl_clock_start = t;
+    return t - ccnl_clock_start;
+}
 
-    if (!start) {
-        start = tv.tv_sec;
-        start_usec = tv.tv_usec;
-    }
+double
+ccnl_clock_precise(void)
+{
+    double t = ccnl_clock_read(0);
+
+    // the coarse clock may be ahead of a precise reading in between ticks
+    return ccnl_clock_ticking && t < ccnl_clock_cached ? ccnl_clock_cached : t;
+}
+
+void
+ccnl_clock_tick(void)
+{
+    double t = ccnl_clock_read(1);
 
-    return (double)(tv.tv_sec) - start +
-                ((double)(tv.tv_usec) - start_usec) / 1000000;
+    if (!ccnl_clock_ticking || t > ccnl_clock_cached)
+        ccnl_clock_cached = t;
+    ccnl_clock_ticking = 1;
+}
+
+double
+current_time(void)
+{
+    return ccnl_clock_ticking ? ccnl_clock_cached : ccnl_clock_read(0);
 }
 
 char*
 timestamp(void)
 {
-    static char ts[30], *cp;
+    static CCNL_THREADLOCAL char ts[30];
+    char *cp;
 
     sprintf(ts, "%.4g", CCNL_NOW());
     cp = strchr(ts, '.');
@@ -262,6 +517,13 @@ timestamp(void)
 
 // void ccnl_get_timeval(struct timeval *tv);
 
+#if !defined(CCNL_UNIX) && !defined(CCNL_SIMULATION)
+// no per-relay event queues on this platform
+#  define ccnl_timerq_select(q)         ((void)(q), (struct ccnl_timerq_s*) NULL)
+#  define ccnl_timerq_new()             ((struct ccnl_timerq_s*) NULL)
+#  define ccnl_timerq_free(q)           do{}while(0)
+#endif
+
 
 #endif //CCNL_OS_TIME_C
 // eof
@@ -118,14 +118,19 @@ ccnl_ccnb_extract(unsigned char **data, int *datalen,
 {
     unsigned char *start = *data - 2 /* account for outer TAG hdr */, *cp;
     int num, typ, len, oldpos;
-    struct ccnl_prefix_s *p;
+    unsigned char *comp[CCNL_MAX_NAME_COMP];
+    int complen[CCNL_MAX_NAME_COMP];
+    unsigned int comphash[CCNL_MAX_NAME_COMP];
+    struct ccnl_prefix_s name, *p = &name;
     struct ccnl_buf_s *buf, *n = 0, *pub = 0;
     DEBUGMSG(TRACE, "ccnl_ccnb_extract\n");
 
-    p = ccnl_prefix_new(CCNL_SUITE_CCNB, CCNL_MAX_NAME_COMP);
-    p->compcnt = 0;
-    if (!p)
-        return NULL;
+    // the name is collected here, see ccnl_prefix_pack()
+    memset(&name, 0, sizeof(name));
+    name.comp = comp;
+    name.complen = complen;
+    name.comphash = comphash;
+    name.suite = CCNL_SUITE_CCNB;
 
     oldpos = *data - start;
     while (ccnl_ccnb_dehead(data, datalen, &num, &typ) == 0) {
@@ -143,6 +148,7 @@ ccnl_ccnb_extract(unsigned char **data, int *datalen,
                         if (ccnl_ccnb_hunt_for_end(data, datalen, p->comp + p->compcnt,
                                 p->complen + p->compcnt) < 0) goto Bail;
                         p->compcnt++;
+                        ccnl_prefix_comphash(p, p->compcnt); // running hash
                     } else {
                         if (ccnl_ccnb_consume(typ, num, data, datalen, 0, 0) < 0)
                             goto Bail;
@@ -197,7 +203,6 @@ ccnl_ccnb_extract(unsigned char **data, int *datalen,
         if (ccnl_ccnb_consume(typ, num, data, datalen, 0, 0) < 0) goto Bail;
         oldpos = *data - start;
     }
-    if (prefix)    *prefix = p;    else free_prefix(p);
     if (nonce)     *nonce = n;     else ccnl_free(n);
     if (ppkd)      *ppkd = pub;    else ccnl_free(pub);
 
@@ -209,10 +214,11 @@ ccnl_ccnb_extract(unsigned char **data, int *datalen,
             p->comp[num] = buf->data + (p->comp[num] - start);
     if (p->nameptr)
         p->nameptr = buf->data + (p->nameptr - start);
+    if (prefix)    *prefix = ccnl_prefix_pack(p); else ccnl_free(p->chunknum);
 
     return buf;
 Bail:
-    free_prefix(p);
+    ccnl_free(p->chunknum);
     free_2ptr_list(n, pub);
     return NULL;
 }
@@ -84,7 +84,10 @@ ccnl_ccntlv_extract(int hdrlen,
     unsigned char *start = *data - hdrlen;
     int i;
     unsigned int len, typ, oldpos;
-    struct ccnl_prefix_s *p;
+    unsigned char *comp[CCNL_MAX_NAME_COMP];
+    int complen[CCNL_MAX_NAME_COMP];
+    unsigned int comphash[CCNL_MAX_NAME_COMP];
+    struct ccnl_prefix_s name, *p = &name;
     struct ccnl_buf_s *buf;
 
     DEBUGMSG(TRACE, "ccnl_ccntlv_extract len=%d hdrlen=%d\n", *datalen, hdrlen);
@@ -94,10 +97,12 @@ ccnl_ccntlv_extract(int hdrlen,
     if (keyid)
         *keyid = NULL;
 
-    p = ccnl_prefix_new(CCNL_SUITE_CCNTLV, CCNL_MAX_NAME_COMP);
-    p->compcnt = 0;
-    if (!p)
-        return NULL;
+    // the name is collected here, see ccnl_prefix_pack()
+    memset(&name, 0, sizeof(name));
+    name.comp = comp;
+    name.complen = complen;
+    name.comphash = comphash;
+    name.suite = CCNL_SUITE_CCNTLV;
 
     // We ignore the TL types of the message for now
     // content and interests are filled in both cases (and only one exists)
@@ -134,12 +139,14 @@ ccnl_ccntlv_extract(int hdrlen,
                         p->comp[p->compcnt] = cp2;
                         p->complen[p->compcnt] = cp - cp2 + len3;
                         p->compcnt++;
+                        ccnl_prefix_comphash(p, p->compcnt); // running hash
                     } // else out of name component memory: skip
                 } else if (typ == CCNX_TLV_N_NameSegment) {
                     if (p->compcnt < CCNL_MAX_NAME_COMP) {
                         p->comp[p->compcnt] = cp2;
                         p->complen[p->compcnt] = cp - cp2 + len3;
                         p->compcnt++;
+                        ccnl_prefix_comphash(p, p->compcnt); // running hash
                     } // else out of name component memory: skip
                 }
                 cp += len3;
@@ -188,8 +195,6 @@ ccnl_ccntlv_extract(int hdrlen,
     if (*datalen > 0)
         goto Bail;
 
-    if (prefix)    *prefix = p;    else free_prefix(p);
-
     buf = ccnl_buf_new(start, *data - start);
     // carefully rebase ptrs to new buf because of 64bit pointers:
     if (content && *content)
@@ -198,10 +203,11 @@ ccnl_ccntlv_extract(int hdrlen,
             p->comp[i] = buf->data + (p->comp[i] - start);
     if (p->nameptr)
         p->nameptr = buf->data + (p->nameptr - start);
+    if (prefix)    *prefix = ccnl_prefix_pack(p); else ccnl_free(p->chunknum);
 
     return buf;
 Bail:
-    free_prefix(p);
+    ccnl_free(p->chunknum);
     return NULL;
 }
 
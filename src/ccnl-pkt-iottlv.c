@@ -93,18 +93,17 @@ struct ccnl_prefix_s *
 ccnl_iottlv_parseHierarchicalName(unsigned char *data, int datalen)
 {
     int typ, len = datalen, len2;
-    struct ccnl_prefix_s *p;
-
-    p = (struct ccnl_prefix_s *) ccnl_calloc(1, sizeof(struct ccnl_prefix_s));
-    if (!p)
-        return NULL;
-    p->suite = CCNL_SUITE_IOTTLV;
-    p->comp = (unsigned char**) ccnl_malloc(CCNL_MAX_NAME_COMP *
-                                           sizeof(unsigned char**));
-    p->complen = (int*) ccnl_malloc(CCNL_MAX_NAME_COMP * sizeof(int));
-    if (!p->comp || !p->complen)
-        return NULL;
-
+    unsigned char *comp[CCNL_MAX_NAME_COMP];
+    int complen[CCNL_MAX_NAME_COMP];
+    unsigned int comphash[CCNL_MAX_NAME_COMP];
+    struct ccnl_prefix_s name, *p = &name;
+
+    // the name is collected here, see ccnl_prefix_pack()
+    memset(&name, 0, sizeof(name));
+    name.comp = comp;
+    name.complen = complen;
+    name.comphash = comphash;
+    name.suite = CCNL_SUITE_IOTTLV;
     p->nameptr = data;
     p->namelen = len;
     while (len > 0) {
@@ -115,6 +114,7 @@ ccnl_iottlv_parseHierarchicalName(unsigned char *data, int datalen)
             p->comp[p->compcnt] = data;
             p->complen[p->compcnt] = len2;
             p->compcnt++;
+            ccnl_prefix_comphash(p, p->compcnt); // running hash
         }
         data += len2;
         len -= len2;
@@ -133,9 +133,8 @@ ccnl_iottlv_parseHierarchicalName(unsigned char *data, int datalen)
             }
 #endif
 
-    return p;
+    return ccnl_prefix_pack(p);
   Bail:
-    free_prefix(p);
     return NULL;
 }
 
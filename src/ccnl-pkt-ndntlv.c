@@ -82,6 +82,7 @@ struct ccnl_buf_s*
 ccnl_ndntlv_extract(int hdrlen,
                     unsigned char **data, int *datalen,
                     int *scope, int *mbf, int *min, int *max,
+                    int *lifetime, int *freshness,
                     unsigned int *final_block_id,
                     struct ccnl_prefix_s **prefix,
                     struct ccnl_prefix_s **tracing,
@@ -91,7 +92,10 @@ ccnl_ndntlv_extract(int hdrlen,
 {
     unsigned char *start = *data - hdrlen;
     int i, len, typ, oldpos;
-    struct ccnl_prefix_s *p;
+    unsigned char *comp[CCNL_MAX_NAME_COMP];
+    int complen[CCNL_MAX_NAME_COMP];
+    unsigned int comphash[CCNL_MAX_NAME_COMP];
+    struct ccnl_prefix_s name, *p = &name;
     struct ccnl_buf_s *buf, *n = 0, *pub = 0;
 
     DEBUGMSG(DEBUG, "extracting NDNTLV packet\n");
@@ -99,10 +103,12 @@ ccnl_ndntlv_extract(int hdrlen,
     if (content)
         *content = NULL;
 
-    p = ccnl_prefix_new(CCNL_SUITE_NDNTLV, CCNL_MAX_NAME_COMP);
-    p->compcnt = 0;
-    if (!p)
-        return NULL;
+    // the name is collected here, see ccnl_prefix_pack()
+    memset(&name, 0, sizeof(name));
+    name.comp = comp;
+    name.complen = complen;
+    name.comphash = comphash;
+    name.suite = CCNL_SUITE_NDNTLV;
 
     oldpos = *data - start;
     while (ccnl_ndntlv_dehead(data, datalen, &typ, &len) == 0) {
@@ -126,6 +132,7 @@ ccnl_ndntlv_extract(int hdrlen,
                     p->comp[p->compcnt] = cp;
                     p->complen[p->compcnt] = i;
                     p->compcnt++;
+                    ccnl_prefix_comphash(p, p->compcnt); // running hash
                 }  // else unknown type: skip
                 cp += i;
                 len2 -= i;
@@ -151,7 +158,7 @@ ccnl_ndntlv_extract(int hdrlen,
 
                 if (typ == NDN_TLV_MinSuffixComponents && min)
                     *min = ccnl_ndntlv_nonNegInt(cp, i);
-                if (typ == NDN_TLV_MinSuffixComponents && max)
+                if (typ == NDN_TLV_MaxSuffixComponents && max)
                     *max = ccnl_ndntlv_nonNegInt(cp, i);
                 if (typ == NDN_TLV_MustBeFresh && mbf)
                     *mbf = 1;
@@ -170,6 +177,10 @@ ccnl_ndntlv_extract(int hdrlen,
             if (scope)
                 *scope = ccnl_ndntlv_nonNegInt(*data, len);
             break;
+        case NDN_TLV_InterestLifetime:
+            if (lifetime)
+                *lifetime = ccnl_ndntlv_nonNegInt(*data, len);
+            break;
         case NDN_TLV_Content:
             if (content) {
                 *content = *data;
@@ -185,10 +196,8 @@ ccnl_ndntlv_extract(int hdrlen,
                     // = ccnl_ndntlv_nonNegInt(cp, i);
                     DEBUGMSG(WARNING, "'ContentType' field ignored\n");
                 }
-                if (typ == NDN_TLV_FreshnessPeriod)
-                    // Not used
-                    // = ccnl_ndntlv_nonNegInt(cp, i);
-                    DEBUGMSG(WARNING, "'FreshnessPeriod' field ignored\n");
+                if (typ == NDN_TLV_FreshnessPeriod && freshness)
+                    *freshness = ccnl_ndntlv_nonNegInt(cp, i);
                 if (typ == NDN_TLV_FinalBlockId) {
                     if (ccnl_ndntlv_dehead(&cp, &len2, &typ, &i))
                         goto Bail;
@@ -211,7 +220,6 @@ ccnl_ndntlv_extract(int hdrlen,
     if (*datalen > 0)
         goto Bail;
 
-    if (prefix)    *prefix = p;    else free_prefix(p);
     if (nonce)     *nonce = n;     else ccnl_free(n);
     if (ppkl)      *ppkl = pub;    else ccnl_free(pub);
 
@@ -223,10 +231,11 @@ ccnl_ndntlv_extract(int hdrlen,
         p->comp[i] = buf->data + (p->comp[i] - start);
     if (p->nameptr)
         p->nameptr = buf->data + (p->nameptr - start);
+    if (prefix)    *prefix = ccnl_prefix_pack(p); else ccnl_free(p->chunknum);
 
     return buf;
 Bail:
-    free_prefix(p);
+    ccnl_free(p->chunknum);
     free_2ptr_list(n, pub);
     return NULL;
 }
@@ -365,9 +365,10 @@ createRelay (const char * node_name, int cs_inodes, int cs_bytesize, char enable
     if (! r)
         return 0;
 
+    r->timerq = ccnl_timerq_new(); // NULL: use the thread's default
     r->max_cache_entries = cs_inodes;
+    r->max_cache_bytes = cs_bytesize;
 
-    // TODO: set somewhere the cs storage size
     // TODO: save somewhere a str name for the relay
 
     if (enable_stats) {
@@ -428,11 +429,8 @@ startRelay (void *relay) {
 
     if (!relay) return;
 
-    ccnl_do_ageing(relay, 0);
-
-    ccnl_set_timer(1000000, ccnl_do_ageing, relay, 0);
-
-    //DEBUGMSG(99, "aging epoch completed for relay %c\n", ((struct ccnl_relay_s *)relay)->id);
+    // nothing to start: faces, PIT entries and cached content age by
+    // themselves, through the timers the core sets for each of them
 
     return;
 };
@@ -876,8 +874,7 @@ fwd_rule_add(struct info_mgmt_s *mgmt)
         }
 
         fwd->face->flags |= CCNL_FACE_FLAGS_STATIC;
-        fwd->next = r->fib;
-        r->fib = fwd;
+        ccnl_fib_add(r, fwd);
 
         //
         cnt++;
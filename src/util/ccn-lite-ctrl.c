@@ -586,7 +586,7 @@ getNDNTLVPrefix(unsigned char *data, int datalen){
     
     if(ccnl_ndntlv_extract(data - cp,
                   &data, &datalen,
-                  &scope, &mbf, &minsfx, &maxsfx, &lastchunknum,
+                  &scope, &mbf, &minsfx, &maxsfx, NULL, NULL, &lastchunknum,
                   &prefix, NULL,
                   &nonce, // nonce
                   &ppkl, //ppkl
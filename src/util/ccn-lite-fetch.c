@@ -129,7 +129,7 @@ ccnl_extractDataAndChunkInfo(unsigned char **data, int *datalen,
         }
 
         buf = ccnl_ndntlv_extract(*data - cp, data, datalen,
-                                  0, 0, 0, 0, 
+                                  0, 0, 0, 0, 0, 0,
                                   lastchunknum,
                                   prefix, 
                                   NULL, 0, 0, 
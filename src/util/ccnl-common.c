@@ -70,6 +70,8 @@ int debug_level = WARNING;
 #define free_2ptr_list(a,b)     ccnl_free(a), ccnl_free(b)
 
 struct ccnl_prefix_s* ccnl_prefix_new(int suite, int cnt);
+struct ccnl_prefix_s* ccnl_prefix_pack(struct ccnl_prefix_s *tmp);
+unsigned int ccnl_prefix_comphash(struct ccnl_prefix_s *p, int n);
 int ccnl_pkt_prependComponent(int suite, char *src, int *offset, unsigned char *buf);
 
 #include "../ccnl-pkt-switch.c"
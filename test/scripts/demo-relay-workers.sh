@@ -0,0 +1,71 @@
+#!/bin/sh
+
+# demo-relay-workers.sh -- test/demo for ccn-lite: a relay with several
+# worker processes (-w) must answer interests whose name is shorter than
+# the content's name, whichever worker the kernel gives them to
+USAGE="usage: sh demo-relay-workers.sh [WORKERS]"
+SET_CCNL_HOME_VAR="set system variable CCNL_HOME to your local CCN-Lite installation (.../ccn-lite) and run 'make clean all' in CCNL_HOME/src"
+COMPILE_CCNL="run 'make clean all' in CCNL_HOME/src"
+
+if [ -z "$CCNL_HOME" ]
+then
+    echo $SET_CCNL_HOME_VAR
+    exit 1
+fi
+
+if [ ! -f "$CCNL_HOME/src/ccn-lite-relay" ]
+then
+    echo $COMPILE_CCNL
+    exit 1
+fi
+
+if [ "$#" -gt 1 ]; then
+    echo $USAGE
+    exit 1
+fi
+
+WORKERS=${1:-4}
+PORT=9997
+UX=/tmp/ccn-lite-relay-$$.sock
+DIR=/tmp/ccn-lite-workers-$$
+SUITE=ndn2013
+COUNT=8
+
+# producing content /wK/a, one prefix per K so that the names spread
+# over the workers' shards
+# ----------------------------------------------------------------------
+
+mkdir -p $DIR
+for K in `seq 1 $COUNT`
+do
+    echo "content$K" | $CCNL_HOME/src/util/ccn-lite-mkC -s $SUITE -o $DIR/c$K.ndntlv "/w$K/a"
+done
+
+# ----------------------------------------------------------------------
+
+$CCNL_HOME/src/ccn-lite-relay -v warning -s $SUITE -u $PORT -x $UX -w $WORKERS -d $DIR 2>/tmp/workers.log &
+RELAY=$!
+sleep 1
+
+# test case: ask for /wK, which only a prefix of the content's name
+FOUND=0
+for K in `seq 1 $COUNT`
+do
+    DATA=`$CCNL_HOME/src/util/ccn-lite-peek -s $SUITE -u 127.0.0.1/$PORT -w 1 "/w$K" | $CCNL_HOME/src/util/ccn-lite-pktdump -f 2`
+    if [ "$DATA" = "content$K" ]
+    then
+        FOUND=`expr $FOUND + 1`
+    else
+        echo "no answer for /w$K"
+    fi
+done
+
+$CCNL_HOME/src/util/ccn-lite-ctrl -x $UX debug halt > /dev/null
+sleep 1
+kill $RELAY 2> /dev/null
+rm -rf $DIR
+
+echo "$FOUND of $COUNT interests answered by $WORKERS workers"
+[ $FOUND = $COUNT ]
+
+# eof
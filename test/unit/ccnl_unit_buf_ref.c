@@ -0,0 +1,57 @@
+#include "test.h"
+#include "../../src/ccnl-headers.h"
+
+
+// shared packet buffers: every holder owns a reference, the last
+// ccnl_buf_release() frees the buf, see ccnl_buf_ref()
+
+int buf_ref_blocks;
+
+//---------------------------------------------------------------------------------------------------
+int ccnl_test_prepare_buf_ref(void **buf, void **data){
+
+	buf_ref_blocks = ccnl_test_memblocks();
+	*data = "chunkedtestcontent";
+	*buf = ccnl_buf_new(*data, strlen(*data));
+
+	return *buf != NULL;
+}
+
+int ccnl_test_run_buf_ref(void *buf, void *data){
+
+	struct ccnl_buf_s *b = buf, *c;
+
+	if (b->refcnt != 1 || b->fp != 0 || b->datalen != strlen(data))
+		return 0;
+	// references share the memory
+	if (ccnl_buf_ref(b) != b || ccnl_buf_ref(b) != b || b->refcnt != 3)
+		return 0;
+	ccnl_buf_release(b);
+	ccnl_buf_release(b);
+	if (b->refcnt != 1 ||
+	    ccnl_test_memblocks() != buf_ref_blocks + 1)
+		return 0;
+	if (ccnl_buf_ref(NULL) != NULL)
+		return 0;
+	ccnl_buf_release(NULL);
+
+	// the fingerprint is computed once, and equal for equal data
+	c = ccnl_buf_new(data, strlen(data));
+	if (!c || !ccnl_buf_fp(b) || ccnl_buf_fp(b) != ccnl_buf_fp(c) ||
+	    !ccnl_buf_same(b, c))
+		return 0;
+	c->data[0] ^= 1;
+	c->fp = 0;
+	if (ccnl_buf_same(b, c))
+		return 0;
+	ccnl_buf_release(c);
+
+	return 1;
+}
+
+int ccnl_test_cleanup_buf_ref(void *buf, void *data){
+
+	ccnl_buf_release(buf);
+	// the last release frees the buf
+	return C_ASSERT_EQUAL_INT(ccnl_test_memblocks(), buf_ref_blocks);
+}
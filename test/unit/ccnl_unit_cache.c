@@ -0,0 +1,295 @@
+#include "test.h"
+#include "../../src/ccnl-headers.h"
+
+
+// the content store replacement policies (ccnl-core-cache.c), driven
+// the way ccnl_content_add2cache() and the lookups drive them: the
+// content objects only carry the name hash which the policies key on
+
+#define CACHE_TEST_KEYS 2000
+
+struct cache_test_s {
+	struct ccnl_relay_s relay;
+	struct ccnl_content_s *slot[CACHE_TEST_KEYS]; // cached content, by key
+	int evicted;	// key of the last victim, or -1
+};
+
+int cache_blocks;
+
+// a request for key: a hit, or a miss which caches the content
+void cache_test_request(struct cache_test_s *t, int key){
+	struct ccnl_relay_s *r = &t->relay;
+	struct ccnl_content_s *c = t->slot[key], *v;
+	int i;
+
+	t->evicted = -1;
+	if (c) {
+		ccnl_cache_hit(r, c);
+		return;
+	}
+	c = ccnl_calloc(1, sizeof(struct ccnl_content_s));
+	c->cslink.hash = key * 2654435761u;
+	ccnl_cache_admit(r, c);
+	while (r->contentcnt >= r->max_cache_entries) {
+		v = ccnl_cache_victim(r);
+		if (!v)
+			break;
+		for (i = 0; t->slot[i] != v; i++);
+		ccnl_cache_remove(r, v);
+		ccnl_free(v);
+		t->slot[i] = NULL;
+		t->evicted = i;
+		r->contentcnt--;
+	}
+	ccnl_cache_insert(r, c);
+	t->slot[key] = c;
+	r->contentcnt++;
+}
+
+// the policy's lists hold exactly the cached content
+int cache_test_consistent(struct cache_test_s *t){
+	struct ccnl_cachestate_s *s = t->relay.cachestate;
+	struct ccnl_content_s *c;
+	int i, cnt = 0, listed = 0;
+
+	for (i = 0; i < CACHE_TEST_KEYS; i++)
+		if (t->slot[i]) {
+			if (!t->slot[i]->cslist)
+				return 0;
+			cnt++;
+		}
+	for (i = 0; i < CCNL_CACHE_LISTS; i++) {
+		int n = 0;
+		for (c = s->list[i].first; c; c = c->cslnext, n++)
+			if (c->cslist != i + 1 || (c->cslnext ?
+				c->cslnext->cslprev != c : s->list[i].last != c))
+				return 0;
+		if (n != s->list[i].cnt)
+			return 0;
+		listed += n;
+	}
+	return cnt == listed && cnt == t->relay.contentcnt &&
+		cnt <= t->relay.max_cache_entries;
+}
+
+int cache_test_cached(struct cache_test_s *t, int key){
+	return t->slot[key] != NULL;
+}
+
+struct cache_test_s* cache_test_new(char *policy, int size){
+	struct cache_test_s *t;
+
+	cache_blocks = ccnl_test_memblocks();
+	t = ccnl_calloc(1, sizeof(*t));
+	t->relay.max_cache_entries = size;
+	if (ccnl_cache_setpolicy(&t->relay, policy)) {
+		ccnl_free(t);
+		return NULL;
+	}
+	return t;
+}
+
+int ccnl_test_cleanup_cache(void *cache, void *policy){
+
+	struct cache_test_s *t = cache;
+	int i;
+
+	for (i = 0; i < CACHE_TEST_KEYS; i++)
+		if (t->slot[i]) {
+			ccnl_cache_remove(&t->relay, t->slot[i]);
+			ccnl_free(t->slot[i]);
+		}
+	ccnl_cache_cleanup(&t->relay);
+	ccnl_free(t);
+	// ghost lists and the sketch are gone, too
+	return C_ASSERT_EQUAL_INT(ccnl_test_memblocks(), cache_blocks);
+}
+
+// random requests, with a few popular keys, keep every policy consistent
+//---------------------------------------------------------------------------------------------------
+int ccnl_test_prepare_cache_random(void **cache, void **policy){
+
+	*cache = cache_test_new(*policy, 64);
+	return *cache != NULL;
+}
+
+int ccnl_test_run_cache_random(void *cache, void *policy){
+
+	struct cache_test_s *t = cache;
+	struct ccnl_cachestate_s *s = t->relay.cachestate;
+	int i, key;
+
+	srandom(4711);
+	for (i = 0; i < 20000; i++) {
+		key = random() % 4 ? random() % 32 : random() % CACHE_TEST_KEYS;
+		cache_test_request(t, key);
+		if (!cache_test_cached(t, key) || !cache_test_consistent(t))
+			return 0;
+		// ARC: |T1|+|B1| <= c, |T1|+|T2|+|B1|+|B2| <= 2c, 0 <= p <= c
+		if (!strcmp(policy, "arc") &&
+		    (s->list[0].cnt + s->ghostcnt[0] > 64 ||
+		     s->list[0].cnt + s->list[1].cnt + s->ghostcnt[0] +
+						s->ghostcnt[1] > 128 ||
+		     s->arc_p < 0 || s->arc_p > 64 ||
+		     s->ghostidx.cnt != s->ghostcnt[0] + s->ghostcnt[1]))
+			return 0;
+	}
+	return C_ASSERT_EQUAL_INT(t->relay.contentcnt, 64);
+}
+
+// LRU evicts the least recently used content
+//---------------------------------------------------------------------------------------------------
+int ccnl_test_prepare_cache_lru(void **cache, void **policy){
+
+	*cache = cache_test_new("lru", 4);
+	return *cache != NULL;
+}
+
+int ccnl_test_run_cache_lru(void *cache, void *policy){
+
+	struct cache_test_s *t = cache;
+	int i;
+
+	for (i = 1; i <= 4; i++)
+		cache_test_request(t, i);
+	cache_test_request(t, 1);
+	cache_test_request(t, 5);
+	if (t->evicted != 2)
+		return 0;
+	cache_test_request(t, 6);
+	return C_ASSERT_EQUAL_INT(t->evicted, 3);
+}
+
+// LFU evicts the least frequently used, the older one on a tie
+//---------------------------------------------------------------------------------------------------
+int ccnl_test_prepare_cache_lfu(void **cache, void **policy){
+
+	*cache = cache_test_new("lfu", 4);
+	return *cache != NULL;
+}
+
+int ccnl_test_run_cache_lfu(void *cache, void *policy){
+
+	struct cache_test_s *t = cache;
+	int i;
+
+	for (i = 1; i <= 4; i++)
+		cache_test_request(t, i);
+	cache_test_request(t, 1);
+	cache_test_request(t, 1);
+	cache_test_request(t, 2);
+	cache_test_request(t, 3);
+	cache_test_request(t, 5);
+	if (t->evicted != 4)
+		return 0;
+	cache_test_request(t, 6);
+	if (t->evicted != 5)
+		return 0;
+	cache_test_request(t, 7);
+	if (t->evicted != 6 || t->slot[1]->freq != 2)
+		return 0;
+	cache_test_request(t, 8);
+	return C_ASSERT_EQUAL_INT(t->evicted, 7);
+}
+
+// ARC: a name found in a ghost list comes back into T2 and moves p
+//---------------------------------------------------------------------------------------------------
+int ccnl_test_prepare_cache_arc(void **cache, void **policy){
+
+	*cache = cache_test_new("arc", 4);
+	return *cache != NULL;
+}
+
+int ccnl_test_run_cache_arc(void *cache, void *policy){
+
+	struct cache_test_s *t = cache;
+	struct ccnl_cachestate_s *s = t->relay.cachestate;
+
+	// T2 = {2, 1}, T1 = {4, 3}
+	cache_test_request(t, 1);
+	cache_test_request(t, 2);
+	cache_test_request(t, 1);
+	cache_test_request(t, 2);
+	cache_test_request(t, 3);
+	cache_test_request(t, 4);
+	if (s->list[0].cnt != 2 || s->list[1].cnt != 2)
+		return 0;
+	// T1 is above its target size p = 0: 3 goes from T1 to B1
+	cache_test_request(t, 5);
+	if (t->evicted != 3 || s->ghostcnt[0] != 1)
+		return 0;
+	// 3 comes back from B1 into T2, and p grows
+	cache_test_request(t, 3);
+	if (t->evicted != 4 || s->arc_p != 1 || t->slot[3]->cslist != 2 ||
+	    s->ghostcnt[0] != 1 || s->list[0].cnt != 1)
+		return 0;
+	// T1 is at its target size: the victim comes from T2, into B2
+	cache_test_request(t, 6);
+	if (t->evicted != 1 || s->ghostcnt[1] != 1)
+		return 0;
+	// 1 comes back from B2, and p shrinks
+	cache_test_request(t, 1);
+	if (t->evicted != 5 || s->arc_p != 0 || t->slot[1]->cslist != 2 ||
+	    s->ghostcnt[0] != 2 || s->ghostcnt[1] != 0)
+		return 0;
+	// a hit moves T1 content to T2
+	cache_test_request(t, 6);
+	if (t->slot[6]->cslist != 2 || s->list[0].cnt != 0)
+		return 0;
+	return cache_test_consistent(t);
+}
+
+// W-TinyLFU: a scan of one-time names does not flush popular content
+//---------------------------------------------------------------------------------------------------
+int ccnl_test_prepare_cache_scan(void **cache, void **policy){
+
+	*cache = cache_test_new(*policy, 100);
+	return *cache != NULL;
+}
+
+int ccnl_test_run_cache_scan(void *cache, void *policy){
+
+	struct cache_test_s *t = cache;
+	int i, j, kept = 0;
+
+	for (j = 0; j < 5; j++)
+		for (i = 0; i < 20; i++)
+			cache_test_request(t, i);
+	for (i = 100; i < 1100; i++)
+		cache_test_request(t, i);
+	for (i = 0; i < 20; i++)
+		kept += cache_test_cached(t, i);
+	if (!cache_test_consistent(t))
+		return 0;
+	// LRU keeps none of them
+	return !strcmp(policy, "lru") ? kept == 0 : kept == 20;
+}
+
+// the sketch saturates at 15 and is halved periodically
+//---------------------------------------------------------------------------------------------------
+int ccnl_test_prepare_cache_sketch(void **cache, void **policy){
+
+	*cache = cache_test_new("wtinylfu", 100);
+	return *cache != NULL;
+}
+
+int ccnl_test_run_cache_sketch(void *cache, void *policy){
+
+	struct cache_test_s *t = cache;
+	struct ccnl_cachestate_s *s = t->relay.cachestate;
+	int i;
+
+	if (s->sketchwidth != CCNL_CACHE_SKETCHMIN)
+		return 0;
+	for (i = 0; i < 40; i++)
+		ccnl_cache_sketch_add(s, 42);
+	if (ccnl_cache_sketch_estimate(s, 42) != 15 ||
+	    ccnl_cache_sketch_estimate(s, 43) > 1)
+		return 0;
+	for (i = s->sketchadds; i < 10 * s->sketchwidth - 1; i++)
+		ccnl_cache_sketch_add(s, 1000 + i);
+	if (ccnl_cache_sketch_estimate(s, 42) != 15)
+		return 0;
+	ccnl_cache_sketch_add(s, 43); // the halving
+	return s->sketchadds == 0 && ccnl_cache_sketch_estimate(s, 42) == 7;
+}
@@ -0,0 +1,151 @@
+#include "test.h"
+#include "../../src/ccnl-headers.h"
+
+
+// the ordered content store index for CCNB and NDNTLV, see
+// ccnl_cstrie_lookup()
+
+#define CSTRIE_TEST_CNT 7
+
+char *cstrie_test_names[CSTRIE_TEST_CNT] = {
+	"/a/bb", "/a/b/x", "/a", "/a/c", "/b", "/a/b", "/a/b/y"
+};
+
+int cstrie_blocks;
+
+struct ccnl_content_s* cstrie_test_content(char *uri){
+	struct ccnl_content_s *c;
+	char buf[100];
+
+	c = ccnl_calloc(1, sizeof(struct ccnl_content_s));
+	c->suite = CCNL_SUITE_NDNTLV;
+	strcpy(buf, uri);
+	c->name = ccnl_URItoPrefix(buf, c->suite, NULL, NULL);
+	c->pkt = ccnl_buf_new(uri, strlen(uri)); // only the digest needs it
+	return c;
+}
+
+// the name of the content found for uri, or "-"
+char* cstrie_test_lookup(struct ccnl_relay_s *relay, char *uri,
+			 int minsfx, int maxsfx, int mbf){
+	struct ccnl_prefix_s *p;
+	struct ccnl_content_s *c;
+	static char name[100];
+	char buf[100];
+
+	strcpy(buf, uri);
+	p = ccnl_URItoPrefix(buf, CCNL_SUITE_NDNTLV, NULL, NULL);
+	c = ccnl_cstrie_lookup(relay, CCNL_SUITE_NDNTLV, p, minsfx, maxsfx,
+			       mbf, NULL);
+	strcpy(name, c ? ccnl_prefix_to_path(c->name) : "-");
+	free_prefix(p);
+	return name;
+}
+
+//---------------------------------------------------------------------------------------------------
+int ccnl_test_prepare_cstrie(void **relay, void **contents){
+
+	struct ccnl_content_s **c;
+	int i;
+
+	cstrie_blocks = ccnl_test_memblocks();
+	*relay = ccnl_calloc(1, sizeof(struct ccnl_relay_s));
+	c = ccnl_calloc(CSTRIE_TEST_CNT, sizeof(*c));
+	for (i = 0; i < CSTRIE_TEST_CNT; i++) {
+		c[i] = cstrie_test_content(cstrie_test_names[i]);
+		ccnl_cstrie_add(*relay, c[i]);
+	}
+	*contents = c;
+
+	return 1;
+}
+
+int ccnl_test_run_cstrie(void *relay, void *contents){
+
+	struct ccnl_relay_s *r = relay;
+	struct ccnl_content_s **c = contents;
+	struct ccnl_csnode_s *n;
+	struct ccnl_prefix_s *p;
+	unsigned char md[32];
+	int i;
+
+	// children in canonical order: shorter first, then memcmp
+	n = r->cstrie[CCNL_SUITE_NDNTLV];
+	if (!n || n->childcnt != 2 || n->child[0]->comp[0] != 'a')
+		return 0;
+	n = n->child[0];
+	if (n->childcnt != 3 || n->contents != c[2] ||
+	    n->child[0]->comp[0] != 'b' || n->child[1]->comp[0] != 'c' ||
+	    n->child[2]->complen != 2)
+		return 0;
+	for (i = 0; i < CSTRIE_TEST_CNT; i++)
+		if (!c[i]->csnode)
+			return 0;
+
+	// the implicit digest is the one suffix component of exact names
+	if (strcmp(cstrie_test_lookup(r, "/a", 0, 1, 0), "/a") ||
+	    strcmp(cstrie_test_lookup(r, "/a", 1, 1, 0), "/a") ||
+	    strcmp(cstrie_test_lookup(r, "/a/c", 0, 64, 0), "/a/c") ||
+	    strcmp(cstrie_test_lookup(r, "/z", 0, 64, 0), "-") ||
+	    strcmp(cstrie_test_lookup(r, "/a/d", 0, 64, 0), "-"))
+		return 0;
+	// the leftmost match, within min and maxsuffix
+	if (strcmp(cstrie_test_lookup(r, "/a", 2, 64, 0), "/a/b") ||
+	    strcmp(cstrie_test_lookup(r, "/a", 3, 64, 0), "/a/b/x") ||
+	    strcmp(cstrie_test_lookup(r, "/a", 4, 64, 0), "-") ||
+	    strcmp(cstrie_test_lookup(r, "/a/b", 2, 2, 0), "/a/b/x") ||
+	    strcmp(cstrie_test_lookup(r, "/a", 2, 1, 0), "-"))
+		return 0;
+
+	// stale content only answers interests without MustBeFresh
+	c[5]->flags |= CCNL_CONTENT_FLAGS_STALE;
+	if (strcmp(cstrie_test_lookup(r, "/a", 2, 2, 0), "/a/b") ||
+	    strcmp(cstrie_test_lookup(r, "/a", 2, 2, 1), "/a/c"))
+		return 0;
+	c[5]->flags &= ~CCNL_CONTENT_FLAGS_STALE;
+
+	// a name ending in the implicit digest finds exactly that content
+	memcpy(md, compute_ccnx_digest(c[5]->pkt), sizeof(md));
+	p = ccnl_prefix_dup(c[5]->name);
+	ccnl_prefix_appendCmp(p, md, sizeof(md));
+	if (ccnl_cstrie_lookup(r, CCNL_SUITE_NDNTLV, p, 0, 1, 0, NULL) != c[5])
+		return 0;
+	p->comp[2][0] ^= 1;
+	p->hashcnt = 0;
+	if (ccnl_cstrie_lookup(r, CCNL_SUITE_NDNTLV, p, 0, 1, 0, NULL))
+		return 0;
+	free_prefix(p);
+
+	// removing content frees the nodes which became empty
+	ccnl_cstrie_remove(r, c[1]);
+	ccnl_cstrie_remove(r, c[1]); // not indexed any more: no-op
+	if (c[1]->csnode || c[5]->csnode->childcnt != 1 ||
+	    strcmp(cstrie_test_lookup(r, "/a", 3, 64, 0), "/a/b/y"))
+		return 0;
+	ccnl_cstrie_remove(r, c[5]);
+	if (strcmp(cstrie_test_lookup(r, "/a/b", 0, 64, 0), "/a/b/y"))
+		return 0;
+	ccnl_cstrie_add(r, c[1]);
+	ccnl_cstrie_add(r, c[5]);
+
+	return C_ASSERT_EQUAL_STRING(cstrie_test_lookup(r, "/a/b", 2, 64, 0),
+				     "/a/b/x");
+}
+
+int ccnl_test_cleanup_cstrie(void *relay, void *contents){
+
+	struct ccnl_relay_s *r = relay;
+	struct ccnl_content_s **c = contents;
+	int i;
+
+	for (i = 0; i < CSTRIE_TEST_CNT; i++) {
+		ccnl_cstrie_remove(r, c[i]);
+		free_content(c[i]);
+	}
+	if (r->cstrie[CCNL_SUITE_NDNTLV])
+		return 0;
+	ccnl_hashtab_cleanup(&r->csmdidx);
+	ccnl_free(c);
+	ccnl_free(r);
+	return C_ASSERT_EQUAL_INT(ccnl_test_memblocks(), cstrie_blocks);
+}
@@ -0,0 +1,121 @@
+#include "test.h"
+#include "../../src/ccnl-headers.h"
+
+
+// a face's queue of packets to send and the set of its bufs which
+// rejects duplicates, see ccnl_face_enqueue() and ccnl_face_fpfind()
+
+#define FACEQ_TEST_VALUES 300
+#define FACEQ_TEST_ROUNDS 20000
+
+int faceq_blocks;
+
+struct ccnl_buf_s *faceq_test_buf(int v){
+	unsigned char data[16];
+
+	memset(data, 'q', sizeof(data));
+	memcpy(data, &v, sizeof(v));
+	return ccnl_buf_new(data, sizeof(data));
+}
+
+int faceq_test_value(struct ccnl_buf_s *b){
+	int v;
+
+	memcpy(&v, b->data, sizeof(v));
+	return v;
+}
+
+// every queued buf is found in the set, and the set holds nothing else
+int faceq_test_set_ok(struct ccnl_face_s *f){
+	struct ccnl_buf_s *b;
+	int j, cnt = 0;
+
+	for (j = 0; j < 2 * f->outqmax; j++)
+		if (f->outqset[j])
+			cnt++;
+	if (cnt != f->outqlen)
+		return 0;
+	for (j = 0; j < f->outqlen; j++) {
+		b = f->outq[(f->outqfront + j) % f->outqmax];
+		if (*ccnl_face_fpfind(f, b) != b)
+			return 0;
+	}
+	return 1;
+}
+
+//---------------------------------------------------------------------------------------------------
+int ccnl_test_prepare_face_queue(void **relay, void **face){
+
+	struct ccnl_relay_s *r;
+	struct ccnl_face_s *f;
+
+	faceq_blocks = ccnl_test_memblocks();
+	r = ccnl_calloc(1, sizeof(struct ccnl_relay_s));
+	f = ccnl_calloc(1, sizeof(struct ccnl_face_s));
+	if (!r || !f)
+		return 0;
+	// the interface is full, so the face keeps what it is given
+	r->ifcount = 1;
+	r->ifs[0].qmax = r->ifs[0].qlen = 1;
+	*relay = r;
+	*face = f;
+
+	return 1;
+}
+
+int ccnl_test_run_face_queue(void *relay, void *face){
+
+	struct ccnl_relay_s *r = relay;
+	struct ccnl_face_s *f = face;
+	struct ccnl_buf_s *b;
+	int queued[FACEQ_TEST_VALUES], fifo[CCNL_MAX_FACE_QLEN];
+	int front = 0, len = 0, i, v, rc;
+
+	memset(queued, 0, sizeof(queued));
+	srandom(42);
+	for (i = 0; i < FACEQ_TEST_ROUNDS; i++) {
+		// grow to a few hundred packets, then shrink again
+		if (len > 0 && random() % 100 < (i % 4000 < 2000 ? 40 : 60)) {
+			b = ccnl_face_dequeue(r, f);
+			if (!b || faceq_test_value(b) != fifo[front])
+				return 0;
+			queued[fifo[front]] = 0;
+			front = (front + 1) % CCNL_MAX_FACE_QLEN;
+			len--;
+			ccnl_buf_release(b);
+		} else {
+			v = random() % FACEQ_TEST_VALUES;
+			rc = ccnl_face_enqueue(r, f, faceq_test_buf(v));
+			if ((rc < 0) != queued[v])
+				return 0;
+			if (rc >= 0) {
+				queued[v] = 1;
+				fifo[(front + len) % CCNL_MAX_FACE_QLEN] = v;
+				len++;
+			}
+		}
+		if (f->outqlen != len || (len && !faceq_test_set_ok(f)))
+			return 0;
+	}
+	// the same buf twice is a duplicate, too
+	b = faceq_test_buf(FACEQ_TEST_VALUES);
+	ccnl_buf_ref(b);
+	if (ccnl_face_enqueue(r, f, b) < 0 || ccnl_face_enqueue(r, f, b) >= 0)
+		return 0;
+	return C_ASSERT_EQUAL_INT(f->outqlen, len + 1);
+}
+
+int ccnl_test_cleanup_face_queue(void *relay, void *face){
+
+	struct ccnl_relay_s *r = relay;
+	struct ccnl_face_s *f = face;
+	struct ccnl_buf_s *b;
+
+	while ((b = ccnl_face_dequeue(r, f)))
+		ccnl_buf_release(b);
+	ccnl_free(f->outq);
+	ccnl_free(f->outqset);
+	ccnl_free(f);
+	ccnl_free(r);
+	return C_ASSERT_EQUAL_INT(ccnl_test_memblocks(), faceq_blocks);
+}
@@ -0,0 +1,135 @@
+#include "test.h"
+#include "../../src/ccnl-headers.h"
+
+
+// the chained hash tables which index the PIT, FIB, faces and the
+// content store, see ccnl_hashtab_add()
+
+#define HASHTAB_TEST_CNT 1000
+
+struct hashtab_test_obj {
+	struct ccnl_hashlink_s link;
+	int id;
+};
+
+int hashtab_blocks;
+
+// pairs of objects share a hash, and many hashes share a bucket
+unsigned int hashtab_test_hash(int id){
+	return (id / 2) * 64;
+}
+
+// counts the objects linked under the hash of id, -1 if id is missing
+int hashtab_test_find(struct ccnl_hashtab_s *t, int id){
+	struct ccnl_hashlink_s *l;
+	int cnt = 0, found = 0;
+
+	for (l = ccnl_hashtab_first(t, hashtab_test_hash(id)); l;
+						l = ccnl_hashtab_next(l)) {
+		if (l->hash != hashtab_test_hash(id))
+			return -2;
+		if (((struct hashtab_test_obj*) l->obj)->id == id)
+			found = 1;
+		cnt++;
+	}
+	return found ? cnt : -1;
+}
+
+//---------------------------------------------------------------------------------------------------
+int ccnl_test_prepare_hashtab(void **tab, void **objs){
+
+	hashtab_blocks = ccnl_test_memblocks();
+	*tab = ccnl_calloc(1, sizeof(struct ccnl_hashtab_s));
+	*objs = ccnl_calloc(HASHTAB_TEST_CNT, sizeof(struct hashtab_test_obj));
+
+	return *tab && *objs;
+}
+
+int ccnl_test_run_hashtab(void *tab, void *objs){
+
+	struct ccnl_hashtab_s *t = tab;
+	struct hashtab_test_obj *o = objs;
+	int i;
+
+	if (ccnl_hashtab_first(t, 0)) // empty, no buckets yet
+		return 0;
+	for (i = 0; i < HASHTAB_TEST_CNT; i++) {
+		o[i].id = i;
+		ccnl_hashtab_add(t, &o[i].link, hashtab_test_hash(i), o + i);
+		// the table grows with the objects, in powers of two
+		if (t->cnt != i + 1 || t->size < t->cnt || (t->size & (t->size-1)))
+			return 0;
+	}
+	// every object survived the resizes
+	for (i = 0; i < HASHTAB_TEST_CNT; i++)
+		if (hashtab_test_find(t, i) != 2)
+			return 0;
+
+	// remove every object with an odd id
+	for (i = 1; i < HASHTAB_TEST_CNT; i += 2) {
+		ccnl_hashtab_remove(t, &o[i].link);
+		if (o[i].link.obj)
+			return 0;
+	}
+	ccnl_hashtab_remove(t, &o[1].link); // not linked: no-op
+	if (t->cnt != HASHTAB_TEST_CNT / 2)
+		return 0;
+	for (i = 0; i < HASHTAB_TEST_CNT; i++)
+		if (hashtab_test_find(t, i) != (i & 1 ? -1 : 1))
+			return 0;
+
+	// and add them again
+	for (i = 1; i < HASHTAB_TEST_CNT; i += 2)
+		ccnl_hashtab_add(t, &o[i].link, hashtab_test_hash(i), o + i);
+	for (i = 0; i < HASHTAB_TEST_CNT; i++)
+		if (hashtab_test_find(t, i) != 2)
+			return 0;
+	if (ccnl_hashtab_first(t, 1)) // unused hash
+		return 0;
+
+	return C_ASSERT_EQUAL_INT(t->cnt, HASHTAB_TEST_CNT);
+}
+
+int ccnl_test_cleanup_hashtab(void *tab, void *objs){
+
+	struct ccnl_hashtab_s *t = tab;
+
+	ccnl_hashtab_cleanup(t);
+	if (t->size || t->cnt || t->bucket)
+		return 0;
+	ccnl_free(t);
+	ccnl_free(objs);
+	return C_ASSERT_EQUAL_INT(ccnl_test_memblocks(), hashtab_blocks);
+}
+
+// names equal for ccnl_prefix_cmp(CMP_EXACT) hash the same
+//---------------------------------------------------------------------------------------------------
+int ccnl_test_prepare_prefix_hash(void **prefix1, void **prefix2){
+
+	char uri1[100], uri2[100];
+
+	strcpy(uri1, "/path/to/data");
+	*prefix1 = ccnl_URItoPrefix(uri1, CCNL_SUITE_NDNTLV, NULL, NULL);
+	strcpy(uri2, "/path/to/data");
+	*prefix2 = ccnl_URItoPrefix(uri2, CCNL_SUITE_NDNTLV, NULL, NULL);
+
+	return *prefix1 && *prefix2;
+}
+
+int ccnl_test_run_prefix_hash(void *prefix1, void *prefix2){
+
+	struct ccnl_prefix_s *p1 = prefix1;
+	struct ccnl_prefix_s *p2 = prefix2;
+	unsigned int h;
+
+	h = ccnl_prefix_hash(p1->suite, p1, p1->compcnt);
+	if (h != ccnl_prefix_hash(p2->suite, p2, p2->compcnt))
+		return 0;
+	// the suite, a shorter prefix and a different component all count
+	if (h == ccnl_prefix_hash(CCNL_SUITE_CCNTLV, p1, p1->compcnt) ||
+	    h == ccnl_prefix_hash(p1->suite, p1, p1->compcnt - 1))
+		return 0;
+	p2->comp[2][0] = 'D';
+	p2->hashcnt = 0;
+	return h != ccnl_prefix_hash(p2->suite, p2, p2->compcnt);
+}
@@ -0,0 +1,105 @@
+#include "test.h"
+#include "../../src/ccnl-headers.h"
+
+
+// the set of recently seen nonces, a ring with hash chains, see
+// ccnl_nonce_find_or_append()
+
+#define NONCE_TEST_MAX 8
+
+int nonce_blocks;
+
+int nonce_test_seen(struct ccnl_relay_s *relay, unsigned int n, int len){
+	struct ccnl_buf_s *b;
+	unsigned char data[8];
+	int rc;
+
+	memcpy(data, &n, sizeof(n));
+	memset(data + sizeof(n), 'x', sizeof(data) - sizeof(n));
+	b = ccnl_buf_new(data, len);
+	rc = ccnl_nonce_find_or_append(relay, b);
+	ccnl_buf_release(b);
+	return rc < 0;
+}
+
+// every ring entry is reachable through exactly one bucket chain
+int nonce_test_chains_ok(struct ccnl_nonceset_s *s){
+	int i, j, cnt = 0;
+
+	for (i = 0; i <= s->mask; i++)
+		for (j = s->bucket[i]; j >= 0; j = s->ring[j].next) {
+			if ((s->ring[j].hash & s->mask) != i || ++cnt > s->cnt)
+				return 0;
+		}
+	return cnt == s->cnt;
+}
+
+// looks at the ring only, without recording n
+int nonce_test_inring(struct ccnl_nonceset_s *s, unsigned int n){
+	int i;
+
+	for (i = 0; i < s->cnt; i++)
+		if (s->ring[i].len == 4 && !memcmp(s->ring[i].data, &n, 4))
+			return 1;
+	return 0;
+}
+
+//---------------------------------------------------------------------------------------------------
+int ccnl_test_prepare_nonce(void **relay, void **dummy){
+
+	struct ccnl_relay_s *r;
+
+	nonce_blocks = ccnl_test_memblocks();
+	r = ccnl_calloc(1, sizeof(struct ccnl_relay_s));
+	r->max_nonces = NONCE_TEST_MAX;
+	*relay = r;
+
+	return r != NULL;
+}
+
+int ccnl_test_run_nonce(void *relay, void *dummy){
+
+	struct ccnl_relay_s *r = relay;
+	struct ccnl_nonceset_s *s = &r->nonces;
+	unsigned int i;
+
+	for (i = 0; i < NONCE_TEST_MAX; i++)
+		if (nonce_test_seen(r, i, 4))
+			return 0;
+	if (s->cnt != NONCE_TEST_MAX || s->mask != NONCE_TEST_MAX - 1)
+		return 0;
+	for (i = 0; i < NONCE_TEST_MAX; i++)
+		if (!nonce_test_seen(r, i, 4))
+			return 0;
+	// the length counts, not just the bytes
+	if (nonce_test_seen(r, 0, 5) || !nonce_test_seen(r, 0, 5))
+		return 0;
+	// which pushed out the oldest one
+	if (nonce_test_seen(r, 0, 4))
+		return 0;
+	if (!nonce_test_seen(r, 0, 4) || nonce_test_seen(r, 1, 4))
+		return 0;
+
+	// with many more nonces, exactly the last NONCE_TEST_MAX are known
+	for (i = 1000; i < 1500; i++) {
+		if (nonce_test_seen(r, i, 4) || !nonce_test_chains_ok(s))
+			return 0;
+	}
+	for (i = 1000; i < 1500 - NONCE_TEST_MAX; i++)
+		if (nonce_test_inring(s, i))
+			return 0;
+	for (; i < 1500; i++)
+		if (!nonce_test_inring(s, i))
+			return 0;
+	return C_ASSERT_EQUAL_INT(s->cnt, NONCE_TEST_MAX);
+}
+
+int ccnl_test_cleanup_nonce(void *relay, void *dummy){
+
+	struct ccnl_relay_s *r = relay;
+
+	ccnl_free(r->nonces.ring);
+	ccnl_free(r->nonces.bucket);
+	ccnl_free(r);
+	return C_ASSERT_EQUAL_INT(ccnl_test_memblocks(), nonce_blocks);
+}
@@ -0,0 +1,150 @@
+#include "test.h"
+#include "../../src/ccnl-headers.h"
+
+
+// compact prefixes: the struct, comp[], complen[], comphash[] and the
+// component bytes are one allocation, see ccnl_prefix_alloc()
+
+int prefix_alloc_blocks;
+
+int ccnl_test_prefix_hashes_ok(struct ccnl_prefix_s *p){
+	unsigned int h = ccnl_hash_init(0);
+	int i;
+
+	ccnl_prefix_comphash(p, p->compcnt);
+	if (p->comphash && p->hashcnt != p->compcnt)
+		return 0;
+	for (i = 0; i < p->compcnt; i++) {
+		h = ccnl_hash_comp(h, p->comp[i], p->complen[i]);
+		if (p->comphash && p->comphash[i] != h)
+			return 0;
+		if (ccnl_prefix_comphash(p, i + 1) != h)
+			return 0;
+	}
+	return 1;
+}
+
+//compact
+//---------------------------------------------------------------------------------------------------
+int ccnl_test_prepare_prefix_compact(void **prefix, void **cmpstr){
+	char uri[100];
+
+	prefix_alloc_blocks = ccnl_test_memblocks();
+	strcpy(uri, "/path/to/data");
+	*prefix = ccnl_URItoPrefix(uri, CCNL_SUITE_NDNTLV, NULL, NULL);
+	*cmpstr = "/path/to/data";
+
+	return *prefix != NULL;
+}
+
+int ccnl_test_run_prefix_compact(void *prefix, void *cmpstr){
+
+	struct ccnl_prefix_s *p = prefix;
+
+	if (!p->compact || p->compcnt != 3)
+		return 0;
+	// everything lies within the one block
+	if ((void*)p->comp != (void*)(p + 1) || !p->bytes)
+		return 0;
+	if (p->comp[0] != p->bytes || memcmp(p->comp[2], "data", 4))
+		return 0;
+
+	return ccnl_test_prefix_hashes_ok(p) &&
+		C_ASSERT_EQUAL_STRING(ccnl_prefix_to_path(p), cmpstr);
+}
+
+int ccnl_test_cleanup_prefix_alloc(void *prefix, void *cmpstr){
+
+	struct ccnl_prefix_s *p = prefix;
+
+	free_prefix(p);
+	// nothing is left behind
+	return C_ASSERT_EQUAL_INT(ccnl_test_memblocks(), prefix_alloc_blocks);
+}
+
+//dup
+//---------------------------------------------------------------------------------------------------
+int ccnl_test_run_prefix_dup(void *prefix, void *cmpstr){
+
+	struct ccnl_prefix_s *p = prefix, *d;
+	int res;
+
+	p->chunknum = ccnl_malloc(sizeof(int));
+	*p->chunknum = 7;
+	d = ccnl_prefix_dup(p);
+	if (!d)
+		return 0;
+	res = d->compact && d->compcnt == p->compcnt &&
+		d->chunknum && *d->chunknum == 7 &&
+		ccnl_test_prefix_hashes_ok(d) &&
+		ccnl_prefix_hash(d->suite, d, d->compcnt) ==
+				ccnl_prefix_hash(p->suite, p, p->compcnt) &&
+		!ccnl_prefix_cmp(p, NULL, d, CMP_EXACT);
+	// the copy does not share the components
+	res = res && d->comp[0] != p->comp[0];
+	free_prefix(d);
+
+	return res;
+}
+
+//appendCmp turns a compact prefix into one with separate arrays
+//---------------------------------------------------------------------------------------------------
+int ccnl_test_run_prefix_compact_append(void *prefix, void *cmpstr){
+
+	struct ccnl_prefix_s *p = prefix, *q;
+	char uri[100];
+	int res;
+
+	ccnl_prefix_comphash(p, p->compcnt);
+	if (ccnl_prefix_appendCmp(p, (unsigned char*) "cmp", 3) < 0)
+		return 0;
+	if (p->compact || p->compcnt != 4 || (void*)p->comp == (void*)(p + 1))
+		return 0;
+	// a second append frees the arrays of the first
+	if (ccnl_prefix_appendCmp(p, (unsigned char*) "more", 4) < 0)
+		return 0;
+
+	strcpy(uri, "/path/to/data/cmp/more");
+	q = ccnl_URItoPrefix(uri, CCNL_SUITE_NDNTLV, NULL, NULL);
+	res = q && ccnl_test_prefix_hashes_ok(p) &&
+		ccnl_prefix_hash(p->suite, p, p->compcnt) ==
+				ccnl_prefix_hash(q->suite, q, q->compcnt) &&
+		!ccnl_prefix_cmp(p, NULL, q, CMP_EXACT) &&
+		C_ASSERT_EQUAL_STRING(ccnl_prefix_to_path(p),
+				      "/path/to/data/cmp/more");
+	free_prefix(q);
+
+	return res;
+}
+
+//hand-built prefixes own their arrays
+//---------------------------------------------------------------------------------------------------
+int ccnl_test_prepare_prefix_handbuilt(void **prefix, void **cmpstr){
+
+	struct ccnl_prefix_s *p;
+
+	prefix_alloc_blocks = ccnl_test_memblocks();
+	p = ccnl_calloc(1, sizeof(struct ccnl_prefix_s));
+	p->suite = CCNL_SUITE_NDNTLV;
+	p->compcnt = 2;
+	p->comp = ccnl_malloc(sizeof(char*) * p->compcnt);
+	p->complen = ccnl_malloc(sizeof(int) * p->compcnt);
+	p->bytes = ccnl_malloc(6);
+	memcpy(p->bytes, "pathto", 6);
+	p->comp[0] = p->bytes;
+	p->complen[0] = 4;
+	p->comp[1] = p->bytes + 4;
+	p->complen[1] = 2;
+	*prefix = p;
+	*cmpstr = "/path/to";
+
+	return 1;
+}
+
+int ccnl_test_run_prefix_handbuilt(void *prefix, void *cmpstr){
+
+	struct ccnl_prefix_s *p = prefix;
+
+	return !p->compact && ccnl_test_prefix_hashes_ok(p) &&
+		C_ASSERT_EQUAL_STRING(ccnl_prefix_to_path(p), cmpstr);
+}
@@ -2,7 +2,7 @@
 
 
 int ccnl_test_prepare_prefix_to_path_1(void **prefix, void **out){
-	*prefix = ccnl_malloc(sizeof(struct ccnl_prefix_s));
+	*prefix = ccnl_calloc(1, sizeof(struct ccnl_prefix_s));
 	struct ccnl_prefix_s *p = *prefix;
 	p->compcnt = 3;
 	p->comp = ccnl_malloc(sizeof(char*) * p->compcnt);
@@ -21,7 +21,7 @@ int ccnl_test_prepare_prefix_to_path_1(void **prefix, void **out){
 }
 
 int ccnl_test_prepare_prefix_to_path_2(void **prefix, void **out){
-	*prefix = ccnl_malloc(sizeof(struct ccnl_prefix_s));
+	*prefix = ccnl_calloc(1, sizeof(struct ccnl_prefix_s));
 	struct ccnl_prefix_s *p = *prefix;
 	p->compcnt = 4;
 	p->comp = ccnl_malloc(sizeof(char*) * p->compcnt);
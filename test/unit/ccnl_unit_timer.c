@@ -0,0 +1,123 @@
+#include "test.h"
+#include "../../src/ccnl-headers.h"
+
+
+// the timer heap and its handles, see ccnl_set_absolute_timer(); the
+// tests run on a queue of their own, selected with ccnl_timerq_select()
+
+#define TIMER_TEST_CNT 300
+
+int timer_blocks;
+int timer_fired[TIMER_TEST_CNT], timer_firedcnt;
+long timer_timeout[TIMER_TEST_CNT]; // usec
+
+void timer_test_fct(void *aux1, void *aux2){
+	timer_fired[timer_firedcnt++] = (int)(long) aux1;
+}
+
+struct timeval timer_test_tv(int sec, int usec){
+	struct timeval tv;
+
+	tv.tv_sec = sec;
+	tv.tv_usec = usec;
+	return tv;
+}
+
+int timer_test_heap_ok(struct ccnl_timerq_s *q){
+	int i;
+
+	for (i = 0; i < q->cnt; i++)
+		if (q->heap[i]->heappos != i ||
+		    (i > 0 && ccnl_timer_before(q->heap[i], q->heap[(i-1)/2])))
+			return 0;
+	return 1;
+}
+
+//---------------------------------------------------------------------------------------------------
+int ccnl_test_prepare_timer(void **queue, void **handles){
+
+	timer_blocks = ccnl_test_memblocks();
+	*queue = ccnl_timerq_new();
+	*handles = ccnl_calloc(TIMER_TEST_CNT, sizeof(void*));
+	ccnl_timerq_select(*queue);
+	timer_firedcnt = 0;
+
+	return *queue && *handles;
+}
+
+int ccnl_test_run_timer(void *queue, void *handles){
+
+	struct ccnl_timerq_s *q = queue;
+	void **h = handles, *old;
+	struct ccnl_timer_s *t;
+	int i, removed = 0;
+
+	srandom(42);
+	for (i = 0; i < TIMER_TEST_CNT; i++) {
+		// few distinct timeouts: many ties
+		timer_timeout[i] = (random() % 10) * 1000000L +
+						(random() % 3) * 1000;
+		h[i] = ccnl_set_absolute_timer(timer_test_tv(
+					timer_timeout[i] / 1000000,
+					timer_timeout[i] % 1000000),
+					timer_test_fct, (void*)(long) i, NULL);
+		if (!h[i] || !timer_test_heap_ok(q))
+			return 0;
+	}
+	// the pool grew in chunks
+	if (q->cnt != TIMER_TEST_CNT || q->chunkcnt * CCNL_TIMER_CHUNK <
+							TIMER_TEST_CNT)
+		return 0;
+	// remove every third timer, twice: the second time is a no-op
+	for (i = 0; i < TIMER_TEST_CNT; i += 3) {
+		ccnl_rem_timer(h[i]);
+		ccnl_rem_timer(h[i]);
+		removed++;
+		if (!timer_test_heap_ok(q))
+			return 0;
+	}
+	ccnl_rem_timer(NULL);
+	if (q->cnt != TIMER_TEST_CNT - removed)
+		return 0;
+
+	// fire them all: in timeout order, equal timeouts in the order set
+	while ((t = ccnl_timer_first())) {
+		ccnl_timer_fire(t);
+		if (!timer_test_heap_ok(q))
+			return 0;
+	}
+	if (timer_firedcnt != TIMER_TEST_CNT - removed)
+		return 0;
+	for (i = 0; i < timer_firedcnt; i++) {
+		int a = i ? timer_fired[i-1] : -1, b = timer_fired[i];
+		if (b % 3 == 0)
+			return 0;
+		if (a >= 0 && (timer_timeout[a] > timer_timeout[b] ||
+		    (timer_timeout[a] == timer_timeout[b] && a > b)))
+			return 0;
+	}
+
+	// the record of the last timer fired is reused first, under a new
+	// handle: the stale handle does not hit the record's new timer
+	old = h[timer_fired[timer_firedcnt-1]];
+	h[0] = ccnl_set_absolute_timer(timer_test_tv(1, 0), timer_test_fct,
+				       (void*)(long) 0, NULL);
+	if (!h[0] || h[0] == old || ((long) h[0] ^ (long) old) &
+					((1L << CCNL_TIMER_IDXBITS) - 1))
+		return 0;
+	for (i = 1; i < TIMER_TEST_CNT; i++)
+		ccnl_rem_timer(h[i]);
+	if (q->cnt != 1)
+		return 0;
+	ccnl_rem_timer(h[0]);
+	return C_ASSERT_EQUAL_INT(q->cnt, 0);
+}
+
+int ccnl_test_cleanup_timer(void *queue, void *handles){
+
+	ccnl_timerq_free(queue);
+	ccnl_free(handles);
+	if (ccnl_timerq_select(NULL))
+		return 0; // freeing the current queue deselects it
+	return C_ASSERT_EQUAL_INT(ccnl_test_memblocks(), timer_blocks);
+}
@@ -70,5 +70,16 @@ enum {STAT_RCV_I, STAT_RCV_C, STAT_SND_I, STAT_SND_C, STAT_QLEN, STAT_EOP1};
 #include "../../src/ccnl-ext-frag.c"
 #include "../../src/ccnl-ext-crypto.c"
 
+// number of blocks currently allocated by ccnl_malloc() & co, for
+// checking that a data structure frees everything it allocated
+int ccnl_test_memblocks(void){
+	struct mhdr *h;
+	int cnt = 0;
+
+	for (h = mem; h; h = h->next)
+		cnt++;
+	return cnt;
+}
+
 
 #endif
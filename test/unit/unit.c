@@ -9,6 +9,14 @@
 #include "ccnl_unit_uri_2_prefix.c"
 #include "ccnl_unit_prefix_comp.c"
 #include "ccnl_unit_stack_type_const.c"
+#include "ccnl_unit_prefix_alloc.c"
+#include "ccnl_unit_buf_ref.c"
+#include "ccnl_unit_hashtab.c"
+#include "ccnl_unit_cstrie.c"
+#include "ccnl_unit_cache.c"
+#include "ccnl_unit_nonce.c"
+#include "ccnl_unit_timer.c"
+#include "ccnl_unit_face_queue.c"
 
 int main(int argc, char **argv){
 
@@ -82,6 +90,79 @@ int main(int argc, char **argv){
 	++testnum;
 	RUN_TEST(testnum, "Testing stack type const2str", ccnl_test_prepare_stack_type_const_const2str, ccnl_test_run_stack_type_const_const2str, ccnl_test_cleanup_stack_type_const_const2str, str, con2);
 
+	//Test: compact prefix
+	++testnum;
+	RUN_TEST(testnum, "Testing compact prefix", ccnl_test_prepare_prefix_compact, ccnl_test_run_prefix_compact, ccnl_test_cleanup_prefix_alloc, p1, str);
+
+	//Test: compact prefix dup
+	++testnum;
+	RUN_TEST(testnum, "Testing compact prefix dup", ccnl_test_prepare_prefix_compact, ccnl_test_run_prefix_dup, ccnl_test_cleanup_prefix_alloc, p1, str);
+
+	//Test: compact prefix appendCmp
+	++testnum;
+	RUN_TEST(testnum, "Testing appendCmp on a compact prefix", ccnl_test_prepare_prefix_compact, ccnl_test_run_prefix_compact_append, ccnl_test_cleanup_prefix_alloc, p1, str);
+
+	//Test: hand-built prefix
+	++testnum;
+	RUN_TEST(testnum, "Testing hand-built prefix", ccnl_test_prepare_prefix_handbuilt, ccnl_test_run_prefix_handbuilt, ccnl_test_cleanup_prefix_alloc, p1, str);
+
+	//Test: buf references
+	++testnum;
+	RUN_TEST(testnum, "Testing buf references", ccnl_test_prepare_buf_ref, ccnl_test_run_buf_ref, ccnl_test_cleanup_buf_ref, str, str);
+
+	//Test: hash table
+	++testnum;
+	RUN_TEST(testnum, "Testing hash table add, resize and remove", ccnl_test_prepare_hashtab, ccnl_test_run_hashtab, ccnl_test_cleanup_hashtab, str, str);
+
+	//Test: prefix hash
+	++testnum;
+	RUN_TEST(testnum, "Testing prefix hash", ccnl_test_prepare_prefix_hash, ccnl_test_run_prefix_hash, ccnl_test_cleanup_prefix_cmp, p1, p2);
+
+	//Test: content store trie
+	++testnum;
+	RUN_TEST(testnum, "Testing content store trie lookup", ccnl_test_prepare_cstrie, ccnl_test_run_cstrie, ccnl_test_cleanup_cstrie, str, str);
+
+	//Test: cache replacement policies
+	char *policies[] = {"lru", "lfu", "arc", "wtinylfu"};
+	int policy;
+	testdescription = ccnl_malloc(512);
+	for(policy = 0; policy < 4; ++policy){
+		++testnum;
+		sprintf(testdescription, "Testing cache policy %s with random requests", policies[policy]);
+		RUN_TEST(testnum, testdescription, ccnl_test_prepare_cache_random, ccnl_test_run_cache_random, ccnl_test_cleanup_cache, str, policies[policy]);
+	}
+
+	++testnum;
+	RUN_TEST(testnum, "Testing cache policy lru eviction order", ccnl_test_prepare_cache_lru, ccnl_test_run_cache_lru, ccnl_test_cleanup_cache, str, str);
+
+	++testnum;
+	RUN_TEST(testnum, "Testing cache policy lfu eviction order", ccnl_test_prepare_cache_lfu, ccnl_test_run_cache_lfu, ccnl_test_cleanup_cache, str, str);
+
+	++testnum;
+	RUN_TEST(testnum, "Testing cache policy arc ghost lists", ccnl_test_prepare_cache_arc, ccnl_test_run_cache_arc, ccnl_test_cleanup_cache, str, str);
+
+	++testnum;
+	RUN_TEST(testnum, "Testing cache policy lru with a scan", ccnl_test_prepare_cache_scan, ccnl_test_run_cache_scan, ccnl_test_cleanup_cache, str, "lru");
+
+	++testnum;
+	RUN_TEST(testnum, "Testing cache policy wtinylfu with a scan", ccnl_test_prepare_cache_scan, ccnl_test_run_cache_scan, ccnl_test_cleanup_cache, str, "wtinylfu");
+
+	++testnum;
+	RUN_TEST(testnum, "Testing cache policy wtinylfu sketch", ccnl_test_prepare_cache_sketch, ccnl_test_run_cache_sketch, ccnl_test_cleanup_cache, str, str);
+	ccnl_free(testdescription);
+
+	//Test: nonce set
+	++testnum;
+	RUN_TEST(testnum, "Testing nonce set", ccnl_test_prepare_nonce, ccnl_test_run_nonce, ccnl_test_cleanup_nonce, str, str);
+
+	//Test: timer heap
+	++testnum;
+	RUN_TEST(testnum, "Testing timer heap and handles", ccnl_test_prepare_timer, ccnl_test_run_timer, ccnl_test_cleanup_timer, str, str);
+
+	//Test: face queue
+	++testnum;
+	RUN_TEST(testnum, "Testing face queue and its duplicate set", ccnl_test_prepare_face_queue, ccnl_test_run_face_queue, ccnl_test_cleanup_face_queue, str, str);
+
 	return 0;
 }
 